@@ -2,54 +2,100 @@
 #include "utilities.h"
 #include "martinez.h"
 #include "connector.h"
-#include "greiner.h"
-#include "gpc.h"
+#include "clipper.h"
 #include "timer.h"
+#include "threadpool.h"
 #include <fstream>
+#include <cmath>
 
 using namespace std;
 
+/** Area of the contours of p, counting the holes as regions too */
+static double contoursArea (Polygon& p)
+{
+	double area = 0;
+	for (unsigned int i = 0; i < p.ncontours (); i++) {
+		Contour& c = p.contour (i);
+		double a = 0;
+		for (unsigned int j = 0; j < c.nvertices (); j++) {
+			const Point& u = c.vertex (j);
+			const Point& v = c.vertex ((j + 1) % c.nvertices ());
+			a += u.x * v.y - v.x * u.y;
+		}
+		area += fabs (a) / 2;
+	}
+	return area;
+}
 
 int main (int argc, char* argv[])
 {
 	if (argc < 4) {
-		cerr << "Syntax: " << argv[0] << " subject_pol clipping_pol result_pol [I|U|D|X]\n";
+		cerr << "Syntax: " << argv[0] << " subject_pol clipping_pol result_pol [I|U|D|X [E|P]]\n";
 		return 1;
 	}
 	if (argc > 4 && argv[4][0] != 'I' && argv[4][0] != 'U' && argv[4][0] != 'D' && argv[4][0] != 'X') {
-		cerr << "Syntax: " << argv[0] << " subject_pol clipping_pol result_pol [I|U|D|X]\n";
-		cerr << "The last parameter is optional. It is a character. It can be I (Intersection), U (Union), D (Difference) or X (eXclusive or)\n";
+		cerr << "Syntax: " << argv[0] << " subject_pol clipping_pol result_pol [I|U|D|X [E|P]]\n";
+		cerr << "The fourth parameter is optional. It is a character. It can be I (Intersection), U (Union), D (Difference) or X (eXclusive or)\n";
+		cerr << "If a fifth parameter E is given, only Martinez's algorithm is run, out of core\n";
+		cerr << "If it is P, the contours of the subject are clipped as open polylines by Martinez's algorithm: I keeps their parts inside the clipping polygon, and the other operations the parts outside\n";
 		return 2;
 	}
 	Martinez::BoolOpType op = Martinez::INTERSECTION;
-	gpc_op opVatti = GPC_INT;
 	if (argc > 4) {
 		switch (argv[4][0]) {
 			case 'I':
 				op = Martinez::INTERSECTION;
-				opVatti = GPC_INT;
 				break;
 			case 'U':
 				op = Martinez::UNION;
-				opVatti = GPC_UNION;
 				break;
 			case 'D':
 				op = Martinez::DIFFERENCE;
-				opVatti = GPC_DIFF;
 				break;
 			case 'X':
 				op = Martinez::XOR;
-				opVatti = GPC_XOR;
 				break;
 		}
 	}
 
+	if (argc > 5 && argv[5][0] == 'E') {
+		Timer timer;
+		timer.start ();
+		bool ok = Martinez::compute (op, argv[1], argv[2], argv[3]);
+		timer.stop ();
+		if (!ok) {
+			cerr << "can't read " << argv[1] << " or " << argv[2] << ", or write " << argv[3] << '\n';
+			return 3;
+		}
+		cout << "Martínez-Rueda's time (out of core): " << timer.timeSecs () << endl;
+		return 0;
+	}
+
+	if (argc > 5 && argv[5][0] == 'P') {
+		Polygon lines (argv[1]);
+		Polygon clip (argv[2]);
+		Polygon result;
+		Martinez mr (lines, clip);
+		Timer timer;
+		timer.start ();
+		mr.clipPolylines (op, result);
+		timer.stop ();
+		ofstream f (argv[3]);
+		if (!f) {
+			cerr << "can't open " << argv[3] << '\n';
+			return 3;
+		}
+		f << result;
+		cout << "Martínez-Rueda's time (polylines): " << timer.timeSecs () << endl;
+		return 0;
+	}
+
 	int ntests = 0; // number of tests
 	Polygon subj (argv[1]);
 	Polygon clip (argv[2]);
 	Polygon martinezResult;
 	Timer timer;
-	int GreinerResult;
+	Clipper::Engine GreinerResult;
 	float Martacum = 0;
 	float Greineracum = 0;
 	float Vattiacum = 0;
@@ -58,42 +104,75 @@ int main (int argc, char* argv[])
 		martinezResult.clear ();
 		// Martínez-Rueda's algorithm
 		timer.start ();
-		Martinez mr (subj, clip);
-		mr.compute (op, martinezResult);
+		Clipper::clip (op, subj, clip, martinezResult, Clipper::Options (Clipper::MARTINEZ));
 		timer.stop ();
 		Martacum += timer.timeSecs();
 		// Greiner-Hormann's algorithm
 		Polygon greinerResult;
 		timer.start ();
-		GreinerHormann gh (subj, clip);
-		GreinerResult = gh.boolop (op, greinerResult);
+		GreinerResult = Clipper::clip (op, subj, clip, greinerResult, Clipper::Options (Clipper::GREINER));
 		timer.stop ();
 		Greineracum += timer.timeSecs();
 		// Vatti's algorithm
-		gpc_polygon subject, clipping, result;
-		gpc_set_polygon (subj, &subject);
-		gpc_set_polygon (clip, &clipping);
+		Polygon vattiResult;
 		timer.start ();
-		gpc_polygon_clip (opVatti, &subject, &clipping, &result);
+		Clipper::clip (op, subj, clip, vattiResult, Clipper::Options (Clipper::VATTI));
 		timer.stop ();
 		Vattiacum += timer.timeSecs();
-		gpc_free_polygon (&subject);
-		gpc_free_polygon (&clipping);
-		gpc_free_polygon (&result);
 	}
 	cout << "Martínez-Rueda's time: " << Martacum / ntests << endl;
 	cout << "Vatti's time: " << Vattiacum / ntests << endl;
 	switch (GreinerResult) {
-		case -1:
-			cout << "Sorry, the Greiner-Hormann's method needs perturbation, and it is not implemented." << endl;
-			break;
-		case -2:
-			cout << "Sorry, the Greiner-Hormann's method cannot work with this operation and polygons with more than one region." << endl;
+		case Clipper::GREINER:
+			cout << "Greiner-Hormann's time: " << Greineracum / ntests << endl;
 			break;
 		default:
-			cout << "Greiner-Hormann's time: " << Greineracum / ntests << endl;
+			cout << "Sorry, the Greiner-Hormann's method could not remove the degeneracies of these polygons by perturbation." << endl;
 			break;
 	}
+	// Martínez-Rueda's algorithm on polygons split at their intersections by all the processors
+	ThreadPool pool;
+	Polygon nodedResult;
+	timer.start ();
+	Clipper::clip (op, subj, clip, nodedResult, Clipper::Options (Clipper::MARTINEZ, 0, &pool));
+	timer.stop ();
+	cout << "Martínez-Rueda's time with pre-noding (" << pool.nthreads () << " threads): " << timer.timeSecs () << endl;
+	// The sweep on the noded polygons must find the same result. Their vertices may differ in the last digits, so their areas
+	// are compared
+	double area = contoursArea (martinezResult), nodedArea = contoursArea (nodedResult);
+	bool nodedDiffers = fabs (area - nodedArea) > 1e-9 * std::max (area, nodedArea);
+	if (nodedDiffers)
+		cerr << "The result with pre-noding differs from Martinez's one: their areas are " << nodedArea << " and " << area << endl;
+	// Martínez-Rueda's algorithm on the independent clusters of contours, by all the processors
+	Polygon clusterResult;
+	timer.start ();
+	Clipper::clip (op, subj, clip, clusterResult, Clipper::Options (Clipper::MARTINEZ, 0, &pool, true));
+	timer.stop ();
+	cout << "Martínez-Rueda's time by clusters (" << pool.nthreads () << " threads): " << timer.timeSecs () << endl;
+	// Martínez-Rueda's algorithm with the contours linked by a second thread
+	Polygon pipelinedResult;
+	Martinez mr (subj, clip);
+	timer.start ();
+	mr.compute (op, pipelinedResult, true);
+	timer.stop ();
+	cout << "Martínez-Rueda's time pipelined (2 threads): " << timer.timeSecs () << endl;
+	// The same object, after an intersection whose sweep may stop early, must find Martinez's result step by step
+	Polygon intersection, steppedResult;
+	mr.compute (Martinez::INTERSECTION, intersection);
+	mr.start (op, steppedResult);
+	while (!mr.resume (16))
+		;
+	double steppedArea = contoursArea (steppedResult);
+	bool steppedDiffers = steppedResult.ncontours () != martinezResult.ncontours () || fabs (area - steppedArea) > 1e-9 * std::max (area, steppedArea);
+	if (steppedDiffers)
+		cerr << "The result computed step by step differs from Martinez's one: " << steppedResult.ncontours () << " contours of area "
+		     << steppedArea << ", and " << martinezResult.ncontours () << " contours of area " << area << endl;
+	// The choice of the front end, with the statistics and the expected times that support it
+	Polygon automaticResult;
+	timer.start ();
+	Clipper::Engine automatic = Clipper::clip (op, subj, clip, automaticResult, Clipper::Options (Clipper::AUTOMATIC, &cout));
+	timer.stop ();
+	cout << "Automatic choice (" << Clipper::name (automatic) << ") time: " << timer.timeSecs () << endl;
 	cout << "Possible intersections: " << subj.nvertices () << " x " << clip.nvertices () << " = " << subj.nvertices()*clip.nvertices() << endl;
 	cout << "Number of tests: " << ntests << endl;
 	ofstream f (argv[3]);
@@ -101,6 +180,6 @@ int main (int argc, char* argv[])
 		cerr << "can't open " << argv[3] << '\n';
 	else
 		f << martinezResult;
-	return 0;
+	return (nodedDiffers || steppedDiffers) ? 4 : 0;
 }
 
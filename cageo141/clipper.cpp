@@ -0,0 +1,341 @@
+#include "clipper.h"
+#include "greiner.h"
+#include "gpc.h"
+#include "rectclip.h"
+#include "convexclip.h"
+#include "noder.h"
+#include "componentclip.h"
+#include "segment.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+// Coefficients of the cost model, in seconds. They were fitted, minimizing the squared logarithm of the ratio between the
+// expected and the measured times, to the times of the three algorithms (-O3) for the four operations on the random
+// polygons and the worldmap files of ../polygons. With them the fastest algorithm is chosen in 68 of 76 cases, and the
+// chosen one is 1.28 times slower than the fastest one on average
+static const double martinezCost = 9.09e-8;
+static const double greinerCost = 1.09e-8;
+static const double greinerIntersectionCost = 2.58e-7;
+static const double greinerContourCost = 1.64e-8;
+static const double vattiCost = 2.33e-8;
+static const double vattiActiveCost = 1.20e-8;
+static const double vattiXorActiveCost = 5.00e-8;
+// Measured apart, clipping the random polygons and the worldmap by random rectangles, and intersecting random convex
+// contours of 1000 vertices
+static const double rectangleCost = 1.5e-8;
+static const double convexCost = 2.5e-8;
+
+static const double pi = 3.14159265358979323846;
+
+static double orientation (const Point& a, const Point& b, const Point& c)
+{
+	return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+/** Is p, collinear with the segment s, inside its bounding box? */
+static bool onSegment (const Segment& s, const Point& p)
+{
+	return std::min (s.p1.x, s.p2.x) <= p.x && p.x <= std::max (s.p1.x, s.p2.x) &&
+	       std::min (s.p1.y, s.p2.y) <= p.y && p.y <= std::max (s.p1.y, s.p2.y);
+}
+
+/** 0 if the segments do not meet, 1 if they cross at a point interior to both (stored in p), and 2 if they touch at a
+ *  vertex or overlap */
+static int meet (const Segment& a, const Segment& b, Point& p)
+{
+	double o1 = orientation (a.p1, a.p2, b.p1);
+	double o2 = orientation (a.p1, a.p2, b.p2);
+	double o3 = orientation (b.p1, b.p2, a.p1);
+	double o4 = orientation (b.p1, b.p2, a.p2);
+	if (((o1 > 0 && o2 < 0) || (o1 < 0 && o2 > 0)) && ((o3 > 0 && o4 < 0) || (o3 < 0 && o4 > 0))) {
+		double t = o3 / (o3 - o4);
+		p = Point (a.p1.x + t * (a.p2.x - a.p1.x), a.p1.y + t * (a.p2.y - a.p1.y));
+		return 1;
+	}
+	if ((o1 == 0 && onSegment (a, b.p1)) || (o2 == 0 && onSegment (a, b.p2)) ||
+	    (o3 == 0 && onSegment (b, a.p1)) || (o4 == 0 && onSegment (b, a.p2)))
+		return 2;
+	return 0;
+}
+
+namespace {
+/** @brief Uniform grid over the window where the polygons overlap. The edges of a polygon that reach the window are
+ *  stored by cell, as a counting sort leaves them: the edges of the cell c are edge[first[c]..first[c+1]) */
+struct EdgeGrid {
+	Point min;
+	double cw, ch; // size of a cell
+	unsigned nx, ny;
+	vector<unsigned> first;
+	vector<Segment> edge;
+	/** @brief Length of the edge divided by the number of cells it is stored in */
+	vector<double> length;
+	EdgeGrid (const Point& mi, const Point& ma, unsigned n) : min (mi), nx (1), ny (1)
+	{
+		// about four edges of every polygon per cell, with square cells
+		double w = std::max (ma.x - mi.x, 1e-300), h = std::max (ma.y - mi.y, 1e-300);
+		double cells = std::max (1.0, std::min (n / 4.0, 65536.0));
+		nx = static_cast<unsigned> (std::max (1.0, std::min (cells, floor (sqrt (cells * w / h)))));
+		ny = static_cast<unsigned> (std::max (1.0, std::min (cells, floor (cells / nx))));
+		cw = w / nx;
+		ch = h / ny;
+	}
+	unsigned column (double x) const { return static_cast<unsigned> (std::min<double> (nx - 1, std::max (0.0, (x - min.x) / cw))); }
+	unsigned row (double y) const { return static_cast<unsigned> (std::min<double> (ny - 1, std::max (0.0, (y - min.y) / ch))); }
+	bool reaches (const Segment& s) const
+	{
+		return std::max (s.p1.x, s.p2.x) >= min.x && std::min (s.p1.x, s.p2.x) <= min.x + nx * cw &&
+		       std::max (s.p1.y, s.p2.y) >= min.y && std::min (s.p1.y, s.p2.y) <= min.y + ny * ch;
+	}
+	/** Store the edges of p in the cells overlapped by their bounding boxes */
+	void add (Polygon& p)
+	{
+		first.assign (nx * ny + 1, 0);
+		for (int pass = 0; pass < 2; pass++) {
+			for (unsigned i = 0; i < p.ncontours (); i++) {
+				Contour& c = p.contour (i);
+				for (unsigned j = 0; j < c.nvertices (); j++) {
+					Segment s = c.segment (j);
+					if (!reaches (s))
+						continue;
+					unsigned x0 = column (std::min (s.p1.x, s.p2.x)), x1 = column (std::max (s.p1.x, s.p2.x));
+					unsigned y0 = row (std::min (s.p1.y, s.p2.y)), y1 = row (std::max (s.p1.y, s.p2.y));
+					double l = s.p1.dist (s.p2) / ((x1 - x0 + 1) * (y1 - y0 + 1));
+					for (unsigned y = y0; y <= y1; y++)
+						for (unsigned x = x0; x <= x1; x++) {
+							if (pass == 0)
+								first[y * nx + x]++;
+							else {
+								edge[--first[y * nx + x]] = s;
+								length[first[y * nx + x]] = l;
+							}
+						}
+				}
+			}
+			if (pass == 0) {
+				// first[c] is the end of the cell c. The second pass fills every cell from its end to its beginning
+				for (unsigned c = 1; c + 1 < first.size (); c++)
+					first[c] += first[c-1];
+				first.back () = first[first.size () - 2];
+				edge.resize (first.back ());
+				length.resize (first.back ());
+			}
+		}
+	}
+};
+}
+
+Clipper::Statistics Clipper::statistics (Polygon& subject, Polygon& clipping)
+{
+	Statistics s;
+	s.subjectVertices = subject.nvertices ();
+	s.clippingVertices = clipping.nvertices ();
+	s.subjectContours = subject.ncontours ();
+	s.clippingContours = clipping.ncontours ();
+	s.intersections = 0;
+	s.degenerate = false;
+	s.overlap = false;
+	Point rmin, rmax;
+	s.rectangle = RectangleClip::isRectangle (subject, rmin, rmax) || RectangleClip::isRectangle (clipping, rmin, rmax);
+	s.convex = ConvexClip::applies (subject, clipping);
+	if (s.subjectVertices == 0 || s.clippingVertices == 0)
+		return s;
+	Point minsubj, maxsubj, minclip, maxclip;
+	subject.boundingbox (minsubj, maxsubj);
+	clipping.boundingbox (minclip, maxclip);
+	s.overlap = minsubj.x <= maxclip.x && minclip.x <= maxsubj.x && minsubj.y <= maxclip.y && minclip.y <= maxsubj.y;
+	if (!s.overlap)
+		return s;
+	// Only the edges inside the window where the bounding boxes overlap can intersect. The window is divided into cells;
+	// the pairs of edges of a cell are tested if they are few, and otherwise their intersections are estimated with the
+	// Buffon-Santalo formula: two sets of randomly placed segments of lengths L1 and L2 in a region of area A cross
+	// 2 L1 L2 / (pi A) times
+	Point min (std::max (minsubj.x, minclip.x), std::max (minsubj.y, minclip.y));
+	Point max (std::min (maxsubj.x, maxclip.x), std::min (maxsubj.y, maxclip.y));
+	EdgeGrid g1 (min, max, s.subjectVertices + s.clippingVertices);
+	EdgeGrid g2 (g1);
+	g1.add (subject);
+	g2.add (clipping);
+	const unsigned maxTests = 64; // pairs of edges tested in a cell
+	for (unsigned y = 0; y < g1.ny; y++)
+		for (unsigned x = 0; x < g1.nx; x++) {
+			unsigned c = y * g1.nx + x;
+			unsigned b1 = g1.first[c], e1 = g1.first[c+1];
+			unsigned b2 = g2.first[c], e2 = g2.first[c+1];
+			if (b1 == e1 || b2 == e2)
+				continue;
+			if ((e1 - b1) * (e2 - b2) <= maxTests) {
+				for (unsigned i = b1; i < e1; i++)
+					for (unsigned j = b2; j < e2; j++) {
+						Point p;
+						switch (meet (g1.edge[i], g2.edge[j], p)) {
+							case 1: // an intersection is counted in the cell where it lies
+								if (g1.column (p.x) == x && g1.row (p.y) == y)
+									s.intersections++;
+								break;
+							case 2:
+								s.degenerate = true;
+								s.intersections++;
+								break;
+						}
+					}
+			} else {
+				double l1 = 0, l2 = 0;
+				for (unsigned i = b1; i < e1; i++)
+					l1 += g1.length[i];
+				for (unsigned j = b2; j < e2; j++)
+					l2 += g2.length[j];
+				s.intersections += 2 * l1 * l2 / (pi * g1.cw * g1.ch);
+			}
+		}
+	return s;
+}
+
+double Clipper::cost (Engine e, Martinez::BoolOpType op, const Statistics& s)
+{
+	double n = static_cast<double> (s.subjectVertices) + s.clippingVertices;
+	double k = s.intersections;
+	switch (e) {
+		case MARTINEZ: // every edge and intersection gives two events, handled in logarithmic time
+			return martinezCost * (n + 2 * k) * log (n + 2 * k + 2);
+		case GREINER: // a sort of the edges, the intersections linked into the vertex lists, and every contour without
+		              // intersections located against the contours of the other polygon
+			return greinerCost * n * log (n + 2) + greinerIntersectionCost * k +
+			       greinerContourCost * s.subjectContours * s.clippingContours;
+		case RECTANGLE: // every edge is visited once
+			return rectangleCost * n;
+		case CONVEX: // every edge is visited at most three times
+			return convexCost * n;
+		case VATTI: // the local minima are sorted, and the active edges are walked once per scanbeam. The exclusive or
+		            // builds many more partial polygons
+			if (op == Martinez::XOR)
+				return vattiXorActiveCost * (n + k) * sqrt (n + k);
+			return vattiCost * (n + k) * log (n + k + 2) + vattiActiveCost * (n + k) * sqrt (n + k);
+		default:
+			return 0;
+	}
+}
+
+Clipper::Engine Clipper::choose (Martinez::BoolOpType op, const Statistics& s)
+{
+	Engine best = MARTINEZ;
+	if (!s.overlap) // every algorithm detects this case at once
+		return best;
+	if (op == Martinez::INTERSECTION && s.rectangle)
+		return RECTANGLE;
+	if (op == Martinez::INTERSECTION && s.convex)
+		return CONVEX;
+	if (!s.degenerate && cost (GREINER, op, s) < cost (best, op, s))
+		best = GREINER;
+	if (cost (VATTI, op, s) < cost (best, op, s))
+		best = VATTI;
+	return best;
+}
+
+const char* Clipper::name (Engine e)
+{
+	switch (e) {
+		case MARTINEZ:
+			return "Martinez";
+		case GREINER:
+			return "Greiner-Hormann";
+		case VATTI:
+			return "Vatti";
+		case RECTANGLE:
+			return "rectangle";
+		case CONVEX:
+			return "convex";
+		default:
+			return "automatic";
+	}
+}
+
+Clipper::Engine Clipper::clip (Martinez::BoolOpType op, Polygon& subject, Polygon& clipping, Polygon& result, const Options& options)
+{
+	Engine engine = options.engine;
+	if (options.trapezoids)
+		options.trapezoids->clear ();
+	Point min, max;
+	if (engine == AUTOMATIC && op == Martinez::INTERSECTION &&
+	    (RectangleClip::isRectangle (clipping, min, max) || RectangleClip::isRectangle (subject, min, max))) {
+		// no statistics are needed: the kernel of the rectangles only walks the edges once
+		engine = RECTANGLE;
+		if (options.log)
+			*options.log << "clip: clipping by a rectangle: " << name (engine) << endl;
+	} else if (engine == AUTOMATIC && op == Martinez::INTERSECTION && ConvexClip::applies (subject, clipping)) {
+		engine = CONVEX;
+		if (options.log)
+			*options.log << "clip: intersection of convex contours: " << name (engine) << endl;
+	}
+	if (engine == AUTOMATIC) {
+		Statistics s = statistics (subject, clipping);
+		engine = choose (op, s);
+		if (options.log)
+			*options.log << "clip: subject " << s.subjectVertices << " vertices " << s.subjectContours << " contours, clipping "
+			             << s.clippingVertices << " vertices " << s.clippingContours << " contours, intersections ~" << s.intersections
+			             << (s.degenerate ? ", degenerate" : "") << ", cost (s) Martinez " << cost (MARTINEZ, op, s) << " Greiner-Hormann "
+			             << cost (GREINER, op, s) << " Vatti " << cost (VATTI, op, s) << ": " << name (engine) << endl;
+	}
+	if (engine == RECTANGLE) {
+		if (op == Martinez::INTERSECTION && RectangleClip::isRectangle (clipping, min, max)) {
+			RectangleClip::compute (subject, min, max, result);
+			return engine;
+		}
+		if (op == Martinez::INTERSECTION && RectangleClip::isRectangle (subject, min, max)) {
+			RectangleClip::compute (clipping, min, max, result);
+			return engine;
+		}
+		engine = MARTINEZ;
+	}
+	if (engine == CONVEX) {
+		if (op == Martinez::INTERSECTION && ConvexClip::applies (subject, clipping)) {
+			ConvexClip::compute (subject, clipping, result);
+			return engine;
+		}
+		engine = MARTINEZ;
+	}
+	switch (engine) {
+		case GREINER: {
+			GreinerHormann gh (subject, clipping);
+			if (gh.boolop (op, result) != -1)
+				break;
+			if (options.log)
+				*options.log << "clip: Greiner-Hormann could not remove the degeneracies, using Martinez" << endl;
+			result.clear ();
+			engine = MARTINEZ; }
+			// fall through
+		case MARTINEZ: {
+			if (options.pool && options.components) {
+				ComponentClip cc (subject, clipping);
+				cc.compute (op, result, *options.pool);
+				break;
+			}
+			if (options.pool) {
+				Polygon nodedSubject, nodedClipping;
+				Noder noder (subject, clipping);
+				noder.compute (nodedSubject, nodedClipping, *options.pool);
+				Martinez mr (nodedSubject, nodedClipping);
+				if (options.trapezoids)
+					mr.compute (op, result, *options.trapezoids);
+				else
+					mr.compute (op, result);
+				break;
+			}
+			Martinez mr (subject, clipping);
+			if (options.trapezoids)
+				mr.compute (op, result, *options.trapezoids);
+			else
+				mr.compute (op, result);
+			break; }
+		default: { // VATTI
+			static const gpc_op vattiOp[] = { GPC_INT, GPC_UNION, GPC_DIFF, GPC_XOR };
+			gpc_polygon s, c;
+			gpc_view_polygon (subject, &s);
+			gpc_view_polygon (clipping, &c);
+			gpc_polygon_clip (vattiOp[op], &s, &c, result);
+			gpc_free_view (&s);
+			gpc_free_view (&c);
+			break; }
+	}
+	return engine;
+}
@@ -0,0 +1,70 @@
+// Front end of the boolean operations. It computes an operation with the algorithm that a cost model, evaluated on cheap
+// statistics of the polygons, expects to be the fastest
+
+#ifndef CLIPPER_H
+#define CLIPPER_H
+
+#include <iostream>
+#include "polygon.h"
+#include "martinez.h"
+
+using namespace std;
+
+class ThreadPool;
+
+class Clipper {
+public:
+	/** RECTANGLE is the kernel of RectangleClip, only for the intersection with an axis-aligned rectangle, and CONVEX is
+	 *  ConvexClip, only for the intersection of two convex contours */
+	enum Engine { AUTOMATIC, MARTINEZ, GREINER, VATTI, RECTANGLE, CONVEX };
+	/** @brief Options of a boolean operation */
+	struct Options {
+		/** Algorithm to use. AUTOMATIC chooses it from the statistics of the polygons */
+		Engine engine;
+		/** If it is not null, the statistics and the decision are written there, in one line */
+		ostream* log;
+		/** If it is not null, Martinez's algorithm splits the edges at their intersections before the sweep, with the threads
+		 *  of the pool (see Noder) */
+		ThreadPool* pool;
+		/** If it is set and pool is not null, Martinez's algorithm computes instead the independent clusters of contours apart,
+		 *  with the threads of the pool (see ComponentClip) */
+		bool components;
+		/** If it is not null and the operation is computed by Martinez's sweep (not by ComponentClip), the sweep also writes
+		 *  there the trapezoids that cover the result. They are left empty by the other algorithms */
+		vector<Martinez::Trapezoid>* trapezoids;
+		Options (Engine e = AUTOMATIC, ostream* l = 0, ThreadPool* p = 0, bool c = false, vector<Martinez::Trapezoid>* t = 0) :
+			engine (e), log (l), pool (p), components (c), trapezoids (t) {}
+	};
+	/** @brief Statistics of the polygons of an operation */
+	struct Statistics {
+		unsigned subjectVertices, clippingVertices;
+		unsigned subjectContours, clippingContours;
+		/** Estimation of the number of intersections between the edges of both polygons */
+		double intersections;
+		/** Whether the bounding boxes of the polygons overlap */
+		bool overlap;
+		/** Whether an edge of a polygon was found touching an edge of the other one at a vertex, or overlapping it (only
+		 *  the sparse parts of the polygons are checked). Greiner-Hormann's algorithm perturbs such polygons, and its
+		 *  result is not exact */
+		bool degenerate;
+		/** Whether one of the polygons is an axis-aligned rectangle */
+		bool rectangle;
+		/** Whether both polygons are single convex contours */
+		bool convex;
+	};
+
+	/** Compute the boolean operation op between subject and clipping. It returns the algorithm used, which differs from
+	 *  options.engine if it is AUTOMATIC, or if Greiner-Hormann's algorithm fails or RECTANGLE or CONVEX do not apply and Martinez's
+	 *  one is used instead */
+	static Engine clip (Martinez::BoolOpType op, Polygon& subject, Polygon& clipping, Polygon& result, const Options& options = Options ());
+	/** Compute the statistics of the polygons, in time linear in their number of edges */
+	static Statistics statistics (Polygon& subject, Polygon& clipping);
+	/** Expected time, in seconds, of the operation op computed by the algorithm e for polygons with statistics s */
+	static double cost (Engine e, Martinez::BoolOpType op, const Statistics& s);
+	/** The algorithm with the lowest expected time. Greiner-Hormann's algorithm is not chosen for degenerate polygons, and
+	 *  the intersection with a rectangle or of convex contours is always computed by RECTANGLE or CONVEX */
+	static Engine choose (Martinez::BoolOpType op, const Statistics& s);
+	static const char* name (Engine e);
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "componentclip.h"
+#include "threadpool.h"
+#include <algorithm>
+
+class ComponentClip::ClusterJob : public Job {
+public:
+	ClusterJob (Martinez::BoolOpType o, vector<Polygon>& s, vector<Polygon>& c, vector<Polygon>& r) : op (o), subj (s), clip (c), result (r) {}
+	void run (unsigned k)
+	{
+		Martinez mr (subj[k], clip[k]);
+		mr.compute (op, result[k]);
+	}
+private:
+	Martinez::BoolOpType op;
+	vector<Polygon>& subj;
+	vector<Polygon>& clip;
+	vector<Polygon>& result;
+};
+
+unsigned ComponentClip::find (vector<unsigned>& parent, unsigned i)
+{
+	while (parent[i] != i) {
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+void ComponentClip::cluster (vector<unsigned>& parent)
+{
+	vector<Box> box;
+	for (unsigned i = 0; i < parent.size (); i++) {
+		Box b;
+		Contour& c = (i < subject.ncontours ()) ? subject.contour (i) : clipping.contour (i - subject.ncontours ());
+		c.boundingbox (b.min, b.max);
+		b.contour = i;
+		box.push_back (b);
+		parent[i] = i;
+	}
+	sort (box.begin (), box.end ());
+	// the active boxes are those that may overlap the next ones along the x-axis
+	vector<unsigned> active;
+	for (unsigned i = 0; i < box.size (); i++) {
+		unsigned n = 0;
+		for (unsigned k = 0; k < active.size (); k++) {
+			const Box& a = box[active[k]];
+			if (a.max.x < box[i].min.x)
+				continue;
+			active[n++] = active[k];
+			if (a.min.y <= box[i].max.y && box[i].min.y <= a.max.y) {
+				unsigned r1 = find (parent, a.contour), r2 = find (parent, box[i].contour);
+				if (r1 != r2)
+					parent[r1] = r2;
+			}
+		}
+		active.resize (n);
+		active.push_back (i);
+	}
+}
+
+void ComponentClip::compute (Martinez::BoolOpType op, Polygon& result, ThreadPool& pool)
+{
+	const unsigned ns = subject.ncontours ();
+	vector<unsigned> parent (ns + clipping.ncontours ());
+	cluster (parent);
+
+	// number the clusters, and find which polygons they hold
+	vector<int> id (parent.size (), -1);
+	vector<int> holds; // bit 0: subject, bit 1: clipping
+	for (unsigned i = 0; i < parent.size (); i++) {
+		unsigned r = find (parent, i);
+		if (id[r] < 0) {
+			id[r] = holds.size ();
+			holds.push_back (0);
+		}
+		holds[id[r]] |= (i < ns) ? 1 : 2;
+	}
+	nclusters = holds.size ();
+	vector<int> swept (nclusters, -1);
+	nswept = 0;
+	for (unsigned k = 0; k < nclusters; k++)
+		if (holds[k] == 3)
+			swept[k] = nswept++;
+
+	// The clusters with contours of only one polygon are not swept
+	vector<Polygon> subj (nswept), clip (nswept), partial (nswept);
+	for (unsigned i = 0; i < parent.size (); i++) {
+		int k = id[find (parent, i)];
+		bool isSubject = i < ns;
+		Contour& c = isSubject ? subject.contour (i) : clipping.contour (i - ns);
+		if (swept[k] >= 0)
+			(isSubject ? subj : clip)[swept[k]].pushbackContour () = c;
+		else if (isSubject ? op != Martinez::INTERSECTION : (op == Martinez::UNION || op == Martinez::XOR))
+			result.pushbackContour () = c;
+	}
+	ClusterJob job (op, subj, clip, partial);
+	pool.run (job, nswept);
+	for (unsigned k = 0; k < nswept; k++)
+		for (unsigned i = 0; i < partial[k].ncontours (); i++)
+			result.pushbackContour () = partial[k].contour (i);
+}
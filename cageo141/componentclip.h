@@ -0,0 +1,51 @@
+// Boolean operation computed on the independent clusters of contours of two polygons, in parallel
+
+#ifndef COMPONENTCLIP_H
+#define COMPONENTCLIP_H
+
+#include "polygon.h"
+#include "martinez.h"
+#include <vector>
+
+using namespace std;
+
+class ThreadPool;
+
+class ComponentClip {
+public:
+	/** Class constructor */
+	ComponentClip (Polygon& sp, Polygon& cp) : subject (sp), clipping (cp), nclusters (0), nswept (0) {}
+	/** Compute the boolean operation op. The contours of both polygons are grouped into clusters, the connected components
+	 *  of the graph that joins the contours whose bounding boxes overlap. A point of a cluster is inside or outside the other
+	 *  contours, so every cluster with contours of both polygons is computed apart by Martinez's algorithm, with the threads
+	 *  of pool. The contours of the other clusters are copied to the result or dropped, as op requires */
+	void compute (Martinez::BoolOpType op, Polygon& result, ThreadPool& pool);
+	/** Number of clusters found in the last computation (for statistics) */
+	unsigned nClusters () const { return nclusters; }
+	/** Number of clusters with contours of both polygons in the last computation (for statistics) */
+	unsigned nSwept () const { return nswept; }
+
+private:
+	/** @brief Bounding box of a contour. The contours of the clipping polygon follow those of the subject */
+	struct Box {
+		Point min, max;
+		unsigned contour;
+		bool operator< (const Box& b) const { return min.x < b.min.x; }
+	};
+	class ClusterJob;
+
+	Polygon& subject;
+	Polygon& clipping;
+	unsigned nclusters;
+	unsigned nswept;
+
+	/** Representative of the set of i, halving the path to it */
+	static unsigned find (vector<unsigned>& parent, unsigned i);
+	/** Join the contours whose bounding boxes overlap, with a sweep of the boxes sorted by x */
+	void cluster (vector<unsigned>& parent);
+
+	ComponentClip (const ComponentClip&);
+	ComponentClip& operator= (const ComponentClip&);
+};
+
+#endif
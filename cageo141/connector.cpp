@@ -80,9 +80,16 @@ void Connector::add(const Segment& s)
 	iterator j = openPolygons.begin ();
 	while (j != openPolygons.end ()) {
 		if (j->LinkSegment (s)) {
-			if (j->closed ())
-				closedPolygons.splice (closedPolygons.end (), openPolygons, j);
-			else {
+			if (j->closed ()) {
+				nclosed++;
+				if (out) {
+					*out << j->size () << " 1\n";
+					for (PointChain::iterator it = j->begin (); it != j->end (); it++)
+						*out << '\t' << it->x << " " << it->y << '\n';
+					openPolygons.erase (j);
+				} else
+					closedPolygons.splice (closedPolygons.end (), openPolygons, j);
+			} else {
 				list<PointChain>::iterator k = j;
 				for (++k; k != openPolygons.end (); k++) {
 					if (j->LinkPointChain (*k)) {
@@ -34,17 +34,22 @@ private:
 class Connector {
 public:
 	typedef list<PointChain>::iterator iterator;
-	Connector () : openPolygons (), closedPolygons () {}
+	Connector () : openPolygons (), closedPolygons (), out (0), nclosed (0) {}
+	/** The closed polygons are written to o as they are found, in the format of the contours of a polygon file, instead of
+	 *  being kept */
+	Connector (ostream& o) : openPolygons (), closedPolygons (), out (&o), nclosed (0) {}
 	~Connector () {}
 	void add (const Segment& s);
 	iterator begin () { return closedPolygons.begin (); }
 	iterator end () { return closedPolygons.end (); }
-	void clear () { closedPolygons.clear (); openPolygons.clear (); }
-	unsigned int size () const { return closedPolygons.size (); }
+	void clear () { closedPolygons.clear (); openPolygons.clear (); nclosed = 0; }
+	unsigned int size () const { return nclosed; }
 	void toPolygon (Polygon& p);
 private:
 	list<PointChain> openPolygons;
 	list<PointChain> closedPolygons;
+	ostream* out;
+	unsigned int nclosed;
 };
 
 
@@ -0,0 +1,156 @@
+#include "convexclip.h"
+#include "martinez.h"
+#include <algorithm>
+
+namespace {
+
+/** @brief Vertices of a contour in counterclockwise order, whatever its orientation */
+class CCWView {
+public:
+	CCWView (Contour& c) : contour (c), n (c.nvertices ()), reversed (!c.counterclockwise ()) {}
+	const Point& operator[] (unsigned i) { return contour.vertex (reversed ? n - 1 - i : i); }
+	unsigned size () const { return n; }
+private:
+	Contour& contour;
+	unsigned n;
+	bool reversed;
+};
+
+/** @brief Which contour is inside the other one just behind the last crossing of their boundaries */
+enum InFlag { P_IN, Q_IN, UNKNOWN };
+
+}
+
+static int orientation (const Point& a, const Point& b, const Point& c)
+{
+	double o = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	return (o > 0) ? 1 : ((o < 0) ? -1 : 0);
+}
+
+/** Is p, collinear with the segment (a, b), inside its bounding box? */
+static bool onSegment (const Point& a, const Point& b, const Point& p)
+{
+	return std::min (a.x, b.x) <= p.x && p.x <= std::max (a.x, b.x) && std::min (a.y, b.y) <= p.y && p.y <= std::max (a.y, b.y);
+}
+
+/** 0 if the segments (a0, a1) and (b0, b1) do not meet, 1 if they cross at a point interior to both (stored in p), and 2 if
+ *  they touch at a vertex or overlap */
+static int meet (const Point& a0, const Point& a1, const Point& b0, const Point& b1, Point& p)
+{
+	int o1 = orientation (a0, a1, b0), o2 = orientation (a0, a1, b1);
+	int o3 = orientation (b0, b1, a0), o4 = orientation (b0, b1, a1);
+	if (o1 * o2 < 0 && o3 * o4 < 0) {
+		double d3 = (b1.x - b0.x) * (a0.y - b0.y) - (b1.y - b0.y) * (a0.x - b0.x);
+		double d4 = (b1.x - b0.x) * (a1.y - b0.y) - (b1.y - b0.y) * (a1.x - b0.x);
+		double t = d3 / (d3 - d4);
+		p = Point (a0.x + t * (a1.x - a0.x), a0.y + t * (a1.y - a0.y));
+		return 1;
+	}
+	if ((o1 == 0 && onSegment (a0, a1, b0)) || (o2 == 0 && onSegment (a0, a1, b1)) ||
+	    (o3 == 0 && onSegment (b0, b1, a0)) || (o4 == 0 && onSegment (b0, b1, a1)))
+		return 2;
+	return 0;
+}
+
+/** 1 if p is strictly inside the convex contour c, 0 if it is on its boundary, and -1 if it is outside */
+static int inside (CCWView& c, const Point& p)
+{
+	int result = 1;
+	for (unsigned i = 0; i < c.size (); i++) {
+		int o = orientation (c[i], c[(i+1) % c.size ()], p);
+		if (o < 0)
+			return -1;
+		if (o == 0)
+			result = 0;
+	}
+	return result;
+}
+
+bool ConvexClip::applies (Polygon& p, Polygon& q)
+{
+	return p.ncontours () == 1 && q.ncontours () == 1 && p.contour (0).convex () && q.contour (0).convex ();
+}
+
+void ConvexClip::compute (Polygon& p, Polygon& q, Polygon& result)
+{
+	if (clip (p.contour (0), q.contour (0), result))
+		return;
+	Martinez mr (p, q);
+	mr.compute (Martinez::INTERSECTION, result);
+}
+
+bool ConvexClip::clip (Contour& pc, Contour& qc, Polygon& result)
+{
+	CCWView P (pc), Q (qc);
+	const unsigned n = P.size (), m = Q.size ();
+	// The edges (P[a-1], P[a]) and (Q[b-1], Q[b]) chase each other around the contours: the one whose line points to the
+	// other edge, or the one outside, advances. Every crossing is found in at most two turns around both contours
+	Contour inter;
+	unsigned a = 0, b = 0, aa = 0, ba = 0; // aa and ba count the advances
+	InFlag inflag = UNKNOWN;
+	bool first = true;
+	do {
+		unsigned a1 = (a + n - 1) % n, b1 = (b + m - 1) % m;
+		const Point& pa = P[a];
+		const Point& pa1 = P[a1];
+		const Point& qb = Q[b];
+		const Point& qb1 = Q[b1];
+		int cross = orientation (Point (0, 0), Point (pa.x - pa1.x, pa.y - pa1.y), Point (qb.x - qb1.x, qb.y - qb1.y));
+		int aHB = orientation (qb1, qb, pa); // is P[a] at the left of the line of the edge of Q?
+		int bHA = orientation (pa1, pa, qb); // is Q[b] at the left of the line of the edge of P?
+		Point x;
+		switch (meet (pa1, pa, qb1, qb, x)) {
+			case 2:
+				return false;
+			case 1:
+				if (inflag == UNKNOWN && first) { // the walk starts again at the first crossing
+					aa = ba = 0;
+					first = false;
+				}
+				if (inter.nvertices () == 0 || inter.vertex (inter.nvertices () - 1) != x)
+					inter.add (x);
+				if (aHB > 0)
+					inflag = P_IN;
+				else if (bHA > 0)
+					inflag = Q_IN;
+				break;
+		}
+		if (cross == 0 && aHB < 0 && bHA < 0) // parallel edges with the contours at opposite sides: they are disjoint
+			break;
+		if (cross == 0 && aHB == 0 && bHA == 0) // collinear edges
+			return false;
+		bool advanceA = (cross >= 0) ? bHA > 0 : aHB <= 0;
+		if (advanceA) {
+			if (inflag == P_IN && inter.vertex (inter.nvertices () - 1) != pa)
+				inter.add (pa);
+			aa++;
+			a = (a + 1) % n;
+		} else {
+			if (inflag == Q_IN && inter.vertex (inter.nvertices () - 1) != qb)
+				inter.add (qb);
+			ba++;
+			b = (b + 1) % m;
+		}
+	} while ((aa < n || ba < m) && aa < 2 * n && ba < 2 * m);
+
+	if (!first) {
+		// the walk ends at the first crossing
+		if (inter.nvertices () > 1 && inter.vertex (0) == inter.vertex (inter.nvertices () - 1))
+			inter.erase (inter.end () - 1);
+		if (inter.nvertices () > 2)
+			result.pushbackContour () = inter;
+		return true;
+	}
+	// The boundaries do not cross: a contour is inside the other one, or they are disjoint
+	int pInQ = inside (Q, P[0]);
+	int qInP = inside (P, Q[0]);
+	if (pInQ == 0 || qInP == 0)
+		return false;
+	CCWView* r = (pInQ > 0) ? &P : ((qInP > 0) ? &Q : 0);
+	if (r) {
+		Contour& c = result.pushbackContour ();
+		for (unsigned i = 0; i < r->size (); i++)
+			c.add ((*r)[i]);
+	}
+	return true;
+}
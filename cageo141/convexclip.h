@@ -0,0 +1,24 @@
+// Intersection of two convex contours in time linear in their number of vertices (O'Rourke, Chien, Olson and Naddor, 1982)
+
+#ifndef CONVEXCLIP_H
+#define CONVEXCLIP_H
+
+#include "polygon.h"
+#include "point.h"
+
+using namespace std;
+
+class ConvexClip {
+public:
+	/** Are p and q single convex contours? */
+	static bool applies (Polygon& p, Polygon& q);
+	/** Compute the intersection of the single convex contours of p and q. The degenerate cases are computed with Martinez's
+	 *  algorithm */
+	static void compute (Polygon& p, Polygon& q, Polygon& result);
+	/** Compute the intersection of the convex contours p and q, adding it to result as a counterclockwise contour. It returns
+	 *  false in degenerate cases (a vertex of a contour on an edge of the other one, or overlapping edges), without changing
+	 *  result */
+	static bool clip (Contour& p, Contour& q, Polygon& result);
+};
+
+#endif
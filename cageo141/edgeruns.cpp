@@ -0,0 +1,115 @@
+#include "edgeruns.h"
+#include <algorithm>
+
+// Number of edges of a run read at once while merging
+static const unsigned blockSize = 4096;
+
+// Is the point p placed before the point q in the sweep?
+static bool before (const Point& p, const Point& q)
+{
+	return p.x < q.x || (p.x == q.x && p.y < q.y);
+}
+
+static bool edgeBefore (const EdgeRuns::Edge& a, const EdgeRuns::Edge& b)
+{
+	return before (a.l, b.l);
+}
+
+bool EdgeRuns::RunComp::operator() (unsigned a, unsigned b) const
+{
+	// std heaps keep the largest element at the front
+	const Run& ra = (*runs)[a];
+	const Run& rb = (*runs)[b];
+	return before (rb.buffer[rb.pos].l, ra.buffer[ra.pos].l);
+}
+
+EdgeRuns::EdgeRuns (unsigned rs) : runSize (std::max (rs, 1u)), edges (), runs (), heap ()
+{
+	comp.runs = &runs;
+}
+
+EdgeRuns::~EdgeRuns ()
+{
+	for (unsigned i = 0; i < runs.size (); i++)
+		if (runs[i].file)
+			fclose (runs[i].file); // a file of tmpfile is removed when it is closed
+}
+
+bool EdgeRuns::add (const Point& a, const Point& b, int pl)
+{
+	if (a == b)
+		return true;
+	Edge e;
+	e.l = before (a, b) ? a : b;
+	e.r = before (a, b) ? b : a;
+	e.pl = pl;
+	edges.push_back (e);
+	return edges.size () < runSize || writeRun ();
+}
+
+bool EdgeRuns::writeRun ()
+{
+	if (edges.empty ())
+		return true;
+	std::sort (edges.begin (), edges.end (), edgeBefore);
+	Run r;
+	r.file = tmpfile ();
+	r.pos = 0;
+	if (!r.file)
+		return false;
+	runs.push_back (r);
+	if (fwrite (&edges[0], sizeof (Edge), edges.size (), r.file) != edges.size ())
+		return false;
+	rewind (r.file);
+	edges.clear ();
+	return true;
+}
+
+bool EdgeRuns::finish ()
+{
+	if (runs.empty () && !edges.empty ()) {
+		// All the edges fit in memory: they are the only run, and it is not written
+		std::sort (edges.begin (), edges.end (), edgeBefore);
+		Run r;
+		r.file = 0;
+		r.pos = 0;
+		runs.push_back (r);
+		runs.back ().buffer.swap (edges);
+		heap.push_back (0);
+		return true;
+	}
+	if (!writeRun ())
+		return false;
+	vector<Edge> ().swap (edges);
+	for (unsigned i = 0; i < runs.size (); i++)
+		if (fill (i))
+			heap.push_back (i);
+	make_heap (heap.begin (), heap.end (), comp);
+	return true;
+}
+
+bool EdgeRuns::fill (unsigned i)
+{
+	Run& r = runs[i];
+	if (!r.file)
+		return false;
+	r.buffer.resize (blockSize);
+	r.buffer.resize (fread (&r.buffer[0], sizeof (Edge), blockSize, r.file));
+	r.pos = 0;
+	return !r.buffer.empty ();
+}
+
+void EdgeRuns::pop ()
+{
+	pop_heap (heap.begin (), heap.end (), comp);
+	unsigned i = heap.back ();
+	if (++runs[i].pos < runs[i].buffer.size () || fill (i)) {
+		push_heap (heap.begin (), heap.end (), comp);
+	} else {
+		heap.pop_back ();
+		vector<Edge> ().swap (runs[i].buffer);
+		if (runs[i].file)
+			fclose (runs[i].file);
+		runs[i].file = 0;
+	}
+}
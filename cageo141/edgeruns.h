@@ -0,0 +1,65 @@
+// Edges sorted by their left endpoints with bounded memory: they are sorted in runs stored in temporary files, and the runs
+// are merged as the edges are taken
+
+#ifndef EDGERUNS_H
+#define EDGERUNS_H
+
+#include "point.h"
+#include <cstdio>
+#include <vector>
+
+using namespace std;
+
+class EdgeRuns {
+public:
+	/** @brief Edge with its endpoints in the order of the sweep (by x, and then by y), and the polygon it belongs to */
+	struct Edge {
+		Point l, r;
+		int pl;
+	};
+	/** Class constructor. At most runSize edges are kept in memory while they are added */
+	EdgeRuns (unsigned runSize = 1 << 20);
+	/** Class destructor. It removes the temporary files */
+	~EdgeRuns ();
+	/** Add the edge (a, b) of the polygon pl. Degenerate edges are discarded. It returns false if a run cannot be written */
+	bool add (const Point& a, const Point& b, int pl);
+	/** Stop adding edges, and start merging the runs. It returns false if a run cannot be written */
+	bool finish ();
+	/** Are all the edges taken? */
+	bool empty () const { return heap.empty (); }
+	/** The first edge not taken yet */
+	const Edge& head () const { return runs[heap.front ()].buffer[runs[heap.front ()].pos]; }
+	/** Take the first edge */
+	void pop ();
+	/** Number of runs (for statistics). If there is only one, it is not written to disk */
+	unsigned nRuns () const { return runs.size (); }
+
+private:
+	/** @brief Run stored in a temporary file, and the block of it that is being merged */
+	struct Run {
+		FILE* file;
+		vector<Edge> buffer;
+		unsigned pos;
+	};
+	/** @brief Orders the runs by their first edge not taken, for a heap with the smallest one at the front */
+	struct RunComp {
+		const vector<Run>* runs;
+		bool operator() (unsigned a, unsigned b) const;
+	};
+
+	unsigned runSize;
+	vector<Edge> edges; // edges of the run being built
+	vector<Run> runs;
+	vector<unsigned> heap;
+	RunComp comp;
+
+	/** Sort the edges added since the last run, and write them to a new temporary file */
+	bool writeRun ();
+	/** Read the next block of edges of run i. It returns false at the end of the run */
+	bool fill (unsigned i);
+
+	EdgeRuns (const EdgeRuns&);
+	EdgeRuns& operator= (const EdgeRuns&);
+};
+
+#endif
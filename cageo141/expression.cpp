@@ -0,0 +1,138 @@
+#include "expression.h"
+#include <cctype>
+
+Expression::Expression (unsigned k) : code (1)
+{
+	code[0].op = OPERAND;
+	code[0].operand = k;
+}
+
+// Skip the blanks of text starting at text[i]
+static void skipBlanks (const string& text, unsigned& i)
+{
+	while (i < text.size () && isspace (static_cast<unsigned char> (text[i])))
+		i++;
+}
+
+bool Expression::parse (const string& text)
+{
+	vector<Instruction> out;
+	unsigned i = 0;
+	if (!parseExpression (text, i, out))
+		return false;
+	skipBlanks (text, i);
+	if (i != text.size ())
+		return false;
+	code.swap (out);
+	return true;
+}
+
+bool Expression::parseExpression (const string& text, unsigned& i, vector<Instruction>& out) const
+{
+	if (!parseTerm (text, i, out))
+		return false;
+	for (;;) {
+		skipBlanks (text, i);
+		if (i == text.size ())
+			return true;
+		Instruction ins = { OPERAND, 0 };
+		switch (text[i]) {
+			case '|':
+				ins.op = UNION;
+				break;
+			case '-':
+				ins.op = DIFFERENCE;
+				break;
+			case '^':
+				ins.op = XOR;
+				break;
+			default:
+				return true;
+		}
+		i++;
+		if (!parseTerm (text, i, out))
+			return false;
+		out.push_back (ins);
+	}
+}
+
+bool Expression::parseTerm (const string& text, unsigned& i, vector<Instruction>& out) const
+{
+	if (!parseFactor (text, i, out))
+		return false;
+	for (;;) {
+		skipBlanks (text, i);
+		if (i == text.size () || text[i] != '&')
+			return true;
+		i++;
+		if (!parseFactor (text, i, out))
+			return false;
+		Instruction ins = { INTERSECTION, 0 };
+		out.push_back (ins);
+	}
+}
+
+bool Expression::parseFactor (const string& text, unsigned& i, vector<Instruction>& out) const
+{
+	skipBlanks (text, i);
+	if (i == text.size ())
+		return false;
+	if (text[i] == '(') {
+		i++;
+		if (!parseExpression (text, i, out))
+			return false;
+		skipBlanks (text, i);
+		if (i == text.size () || text[i] != ')')
+			return false;
+		i++;
+		return true;
+	}
+	if (text[i] < 'A' || text[i] > 'Z')
+		return false;
+	Instruction ins = { OPERAND, static_cast<unsigned> (text[i] - 'A') };
+	out.push_back (ins);
+	i++;
+	return true;
+}
+
+void Expression::combine (Operator op, const Expression& e)
+{
+	code.insert (code.end (), e.code.begin (), e.code.end ());
+	Instruction ins = { op, 0 };
+	code.push_back (ins);
+}
+
+unsigned Expression::noperands () const
+{
+	unsigned n = 0;
+	for (unsigned i = 0; i < code.size (); i++)
+		if (code[i].op == OPERAND && code[i].operand + 1 > n)
+			n = code[i].operand + 1;
+	return n;
+}
+
+bool Expression::evaluate (unsigned mask) const
+{
+	unsigned end = code.size ();
+	return evaluate (mask, end);
+}
+
+bool Expression::evaluate (unsigned mask, unsigned& end) const
+{
+	const Instruction& ins = code[--end];
+	if (ins.op == OPERAND)
+		return (mask >> ins.operand) & 1;
+	// both subexpressions are evaluated, to find where the first one starts
+	bool b = evaluate (mask, end);
+	bool a = evaluate (mask, end);
+	switch (ins.op) {
+		case UNION:
+			return a || b;
+		case INTERSECTION:
+			return a && b;
+		case DIFFERENCE:
+			return a && !b;
+		default:
+			return a != b;
+	}
+}
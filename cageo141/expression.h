@@ -0,0 +1,52 @@
+// Boolean expression over several polygons (the operands), evaluated point by point
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class Expression {
+public:
+	enum Operator { OPERAND, UNION, INTERSECTION, DIFFERENCE, XOR };
+	/** Maximum number of operands: the operands that contain a point are given as the bits of an unsigned */
+	static const unsigned MAX_OPERANDS = 32;
+	/** Class constructor. The expression is the operand k */
+	Expression (unsigned k = 0);
+	/** Parse text, made of the operands A, B, ..., Z (A is the operand 0), the operators | (union), & (intersection),
+	 *  - (difference) and ^ (exclusive or), and parentheses, as in "(A | B) - (C & D)". & takes precedence over the other
+	 *  operators, that are applied from left to right. It returns false if text is not a valid expression, leaving the
+	 *  expression unchanged */
+	bool parse (const string& text);
+	/** Combine the expression with e: the expression becomes (expression op e) */
+	void combine (Operator op, const Expression& e);
+	/** Number of operands the expression refers to (the highest operand plus one) */
+	unsigned noperands () const;
+	/** Is a point inside the result, given the operands that contain it (the bit k of mask is set if the operand k contains it)? */
+	bool evaluate (unsigned mask) const;
+	/** Number of steps of the expression, in postfix order: a step is an operand, or an operator applied to the results of the
+	 *  two subexpressions that end before it */
+	unsigned nsteps () const { return code.size (); }
+	/** Operator of the step i (OPERAND if it is an operand), and operand of the step i */
+	Operator op (unsigned i) const { return code[i].op; }
+	unsigned operand (unsigned i) const { return code[i].operand; }
+
+private:
+	/** @brief Step of the evaluation. The expression is stored in postfix order */
+	struct Instruction {
+		Operator op;
+		unsigned operand; // only for OPERAND
+	};
+	vector<Instruction> code;
+
+	/** Parse the terms joined by |, - and ^ starting at text[i], or the factors joined by & */
+	bool parseExpression (const string& text, unsigned& i, vector<Instruction>& out) const;
+	bool parseTerm (const string& text, unsigned& i, vector<Instruction>& out) const;
+	bool parseFactor (const string& text, unsigned& i, vector<Instruction>& out) const;
+	/** Evaluate the subexpression that ends at code[end-1], setting end to its first instruction */
+	bool evaluate (unsigned mask, unsigned& end) const;
+};
+
+#endif
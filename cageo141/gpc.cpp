@@ -41,6 +41,8 @@ Copyright: (C) Advanced Interfaces Group,
 #include <stdlib.h>
 #include <float.h>
 #include <math.h>
+#include <string.h>
+#include <stdint.h>
 
 
 /*
@@ -90,7 +92,7 @@ Copyright: (C) Advanced Interfaces Group,
 
 #define NOT_RMAX(v, i, n)   (v[PREV_INDEX(i, n)].vertex.y > v[i].vertex.y)
 
-#define VERTEX(e,p,s,x,y)  {add_vertex(&((e)->outp[(p)]->v[(s)]), x, y); \
+#define VERTEX(a,e,p,s,x,y) {add_vertex(a, &((e)->outp[(p)]->v[(s)]), x, y); \
                             (e)->outp[(p)]->active++;}
 
 #define P_EDGE(d,e,p,i,j)  {(d)= (e); \
@@ -108,6 +110,15 @@ Copyright: (C) Advanced Interfaces Group,
 
 #define FREE(p)            {if (p) {free(p); (p)= NULL;}}
 
+#define ARENA_MALLOC(a, p, b, s, t) {p= (t*)arena_alloc(a, b, s);}
+
+#define ARENA_BLOCK        16384    /* Size of the first arena block     */
+#define ARENA_MAX_BLOCK    1048576  /* Size limit of the arena blocks    */
+#define ARENA_ALIGN        16       /* Alignment of the arena nodes      */
+
+/* Define GPC_RADIX_SORT to sort the scanbeam table with a radix sort */
+#define RADIX_BITS         8        /* Key bits sorted by each pass      */
+
 
 /*
 ===========================================================================
@@ -182,22 +193,15 @@ typedef struct edge_shape
   struct edge_shape  *next;         /* Next edge in the AET              */
   struct edge_shape  *pred;         /* Edge connected at the lower end   */
   struct edge_shape  *succ;         /* Edge connected at the upper end   */
-  struct edge_shape  *next_bound;   /* Pointer to next bound in LMT      */
 } edge_node;
 
-typedef struct lmt_shape            /* Local minima table                */
+typedef struct                      /* Local minima and scanbeam tables  */
 {
-  double              y;            /* Y coordinate at local minimum     */
-  edge_node          *first_bound;  /* Pointer to bound list             */
-  struct lmt_shape   *next;         /* Pointer to next local minimum     */
-} lmt_node;
-
-typedef struct sbt_t_shape          /* Scanbeam tree                     */
-{
-  double              y;            /* Scanbeam node y value             */
-  struct sbt_t_shape *less;         /* Pointer to nodes with lower y     */
-  struct sbt_t_shape *more;         /* Pointer to nodes with higher y    */
-} sb_tree;
+  edge_node         **bound;        /* Bounds sorted by local minimum    */
+  int                 bounds;       /* Number of bounds                  */
+  double             *sbt;          /* Sorted scanbeam boundaries        */
+  int                 sbt_entries;  /* Number of scanbeam boundaries     */
+} lmt_table;
 
 typedef struct it_shape             /* Intersection table                */
 {
@@ -215,6 +219,13 @@ typedef struct st_shape             /* Sorted edge table                 */
   struct st_shape    *prev;         /* Previous edge in sorted list      */
 } st_node;
 
+typedef struct                      /* Edge crossing within a scanbeam   */
+{
+  int                 e[2];         /* Sorted edge table indices of pair */
+  int                 rank;         /* ST position of the first edge     */
+  gpc_vertex          point;        /* Point of intersection             */
+} crossing;
+
 typedef struct bbox_shape           /* Contour axis-aligned bounding box */
 {
   double             xmin;          /* Minimum x coordinate              */
@@ -223,6 +234,28 @@ typedef struct bbox_shape           /* Contour axis-aligned bounding box */
   double             ymax;          /* Maximum y coordinate              */
 } bbox;
 
+typedef struct ab_shape             /* Arena memory block                */
+{
+  struct ab_shape    *next;         /* Previously allocated block        */
+  double              pad;          /* Keeps the block data aligned      */
+} arena_block;
+
+typedef struct                      /* Per-call node allocator           */
+{
+  arena_block        *blocks;       /* Blocks allocated so far           */
+  char               *top;          /* Free space of the current block   */
+  size_t              left;         /* Bytes left in the current block   */
+  size_t              block_size;   /* Size of the next block            */
+  it_node            *free_it;      /* Recycled intersection table nodes */
+  st_node            *free_st;      /* Recycled sorted edge table nodes  */
+  st_node            *st_table;     /* Sorted edge table of a scanbeam   */
+  int                 st_size;      /* Capacity of st_table              */
+  int                *st_order;     /* Merge sort order and buffer       */
+  int                 order_size;   /* Capacity of st_order              */
+  crossing           *x_table;      /* Crossings of a scanbeam           */
+  int                 x_size;       /* Capacity of x_table               */
+} node_arena;
+
 
 /*
 ===========================================================================
@@ -247,162 +280,239 @@ const h_state next_h_state[3][6]=
 ===========================================================================
 */
 
-static void reset_it(it_node **it)
+static void init_arena(node_arena *a)
 {
-  it_node *itn;
+  a->blocks= NULL;
+  a->top= NULL;
+  a->left= 0;
+  a->block_size= ARENA_BLOCK;
+  a->free_it= NULL;
+  a->free_st= NULL;
+  a->st_table= NULL;
+  a->st_size= 0;
+  a->st_order= NULL;
+  a->order_size= 0;
+  a->x_table= NULL;
+  a->x_size= 0;
+}
 
-  while (*it)
+
+static void *arena_alloc(node_arena *a, size_t b, const char *s)
+{
+  arena_block *block;
+  size_t       size;
+  void        *p;
+
+  if (b == 0)
+    return NULL;
+
+  /* Round the request up to keep every node aligned */
+  b= (b + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1);
+  if (b > a->left)
   {
-    itn= (*it)->next;
-    FREE(*it);
-    *it= itn;
+    /* Start a new block, twice as large as the previous one */
+    size= (b > a->block_size) ? b : a->block_size;
+    MALLOC(block, sizeof(arena_block) + size, s, arena_block);
+    block->next= a->blocks;
+    a->blocks= block;
+    a->top= (char *) (block + 1);
+    a->left= size;
+    if (a->block_size < ARENA_MAX_BLOCK)
+      a->block_size*= 2;
   }
+  p= a->top;
+  a->top+= b;
+  a->left-= b;
+  return p;
 }
 
 
-static void reset_lmt(lmt_node **lmt)
+static void *arena_grow(node_arena *a, void *p, int *capacity, int used,
+                        int needed, size_t size)
 {
-  lmt_node *lmtn;
+  void *q;
+
+  if (needed <= *capacity)
+    return p;
+
+  /* Reallocate at least twice as large, keeping the used items */
+  *capacity= (needed > 2 * *capacity) ? needed : 2 * *capacity;
+  q= arena_alloc(a, *capacity * size, "table growth");
+  if (used > 0)
+    memcpy(q, p, used * size);
+  return q;
+}
 
-  while (*lmt)
+
+static void release_arena(node_arena *a)
+{
+  arena_block *next;
+
+  /* Every node of the call lives in one of the blocks */
+  while (a->blocks)
   {
-    lmtn= (*lmt)->next;
-    FREE(*lmt);
-    *lmt= lmtn;
+    next= a->blocks->next;
+    free(a->blocks);
+    a->blocks= next;
   }
+  init_arena(a);
 }
 
 
-static void insert_bound(edge_node **b, edge_node *e)
+static void reset_it(node_arena *a, it_node **it)
 {
-  edge_node *existing_bound;
+  it_node *itn;
 
-  if (!*b)
+  if (*it)
   {
-    /* Link node e to the tail of the list */
-    *b= e;
+    /* Hand the whole list over to the arena for reuse */
+    for (itn= *it; itn->next; itn= itn->next);
+    itn->next= a->free_it;
+    a->free_it= *it;
+    *it= NULL;
   }
-  else
+}
+
+
+static int bound_less(edge_node *e0, edge_node *e1)
+{
+  /* Order by local minimum, then by x and by dx at the minimum */
+  if (e0->bot.y != e1->bot.y)
+    return e0->bot.y < e1->bot.y;
+  if (e0->bot.x != e1->bot.x)
+    return e0->bot.x < e1->bot.x;
+  return e0->dx < e1->dx;
+}
+
+
+static void sort_bounds(node_arena *a, edge_node **b, int n)
+{
+  edge_node **src, **dst, **tmp;
+  int         width, lo, mid, hi, i, j, k;
+
+  /* Bottom-up merge sort, stable so equal bounds keep their input order */
+  ARENA_MALLOC(a, tmp, n * sizeof(edge_node *), "bound sorting", edge_node *);
+  src= b;
+  dst= tmp;
+  for (width= 1; width < n; width*= 2)
   {
-    /* Do primary sort on the x field */
-    if (e[0].bot.x < (*b)[0].bot.x)
+    for (lo= 0; lo < n; lo+= 2 * width)
     {
-      /* Insert a new node mid-list */
-      existing_bound= *b;
-      *b= e;
-      (*b)->next_bound= existing_bound;
-    }
-    else
-    {
-      if (e[0].bot.x == (*b)[0].bot.x)
-      {
-        /* Do secondary sort on the dx field */
-        if (e[0].dx < (*b)[0].dx)
-        {
-          /* Insert a new node mid-list */
-          existing_bound= *b;
-          *b= e;
-          (*b)->next_bound= existing_bound;
-        }
+      mid= (lo + width < n) ? lo + width : n;
+      hi= (lo + 2 * width < n) ? lo + 2 * width : n;
+      for (i= lo, j= mid, k= lo; k < hi; k++)
+        if ((j < hi) && ((i == mid) || bound_less(src[j], src[i])))
+          dst[k]= src[j++];
         else
-        {
-          /* Head further down the list */
-          insert_bound(&((*b)->next_bound), e);
-        }
-      }
-      else
-      {
-        /* Head further down the list */
-        insert_bound(&((*b)->next_bound), e);
-      }
+          dst[k]= src[i++];
     }
+    tmp= src;
+    src= dst;
+    dst= tmp;
   }
+  if (src != b)
+    memcpy(b, src, n * sizeof(edge_node *));
 }
 
 
-static edge_node **bound_list(lmt_node **lmt, double y)
+#ifdef GPC_RADIX_SORT
+static uint64_t double_key(double d)
 {
-  lmt_node *existing_node;
+  uint64_t k;
 
-  if (!*lmt)
-  {
-    /* Add node onto the tail end of the LMT */
-    MALLOC(*lmt, sizeof(lmt_node), "LMT insertion", lmt_node);
-    (*lmt)->y= y;
-    (*lmt)->first_bound= NULL;
-    (*lmt)->next= NULL;
-    return &((*lmt)->first_bound);
-  }
-  else
-    if (y < (*lmt)->y)
-    {
-      /* Insert a new LMT node before the current node */
-      existing_node= *lmt;
-      MALLOC(*lmt, sizeof(lmt_node), "LMT insertion", lmt_node);
-      (*lmt)->y= y;
-      (*lmt)->first_bound= NULL;
-      (*lmt)->next= existing_node;
-      return &((*lmt)->first_bound);
-    }
-    else
-      if (y > (*lmt)->y)
-        /* Head further up the LMT */
-        return bound_list(&((*lmt)->next), y);
-      else
-        /* Use this existing LMT node */
-        return &((*lmt)->first_bound);
+  /* Map the double onto an unsigned key with the same order */
+  memcpy(&k, &d, sizeof(k));
+  return (k & 0x8000000000000000ULL) ? ~k : k | 0x8000000000000000ULL;
 }
 
 
-static void add_to_sbtree(int *entries, sb_tree **sbtree, double y)
+static void sort_doubles(node_arena *a, double *v, int n)
 {
-  if (!*sbtree)
-  {
-    /* Add a new tree node here */
-    MALLOC(*sbtree, sizeof(sb_tree), "scanbeam tree insertion", sb_tree);
-    (*sbtree)->y= y;
-    (*sbtree)->less= NULL;
-    (*sbtree)->more= NULL;
-    (*entries)++;
-  }
-  else
+  uint64_t *key, *tmp, *swap;
+  int       count[1 << RADIX_BITS], shift, i, d, sum, c;
+
+  ARENA_MALLOC(a, key, n * sizeof(uint64_t), "scanbeam sorting", uint64_t);
+  ARENA_MALLOC(a, tmp, n * sizeof(uint64_t), "scanbeam sorting", uint64_t);
+  for (i= 0; i < n; i++)
+    key[i]= double_key(v[i]);
+
+  /* Least significant digit first, skipping digits shared by all keys */
+  for (shift= 0; shift < 64; shift+= RADIX_BITS)
   {
-    if ((*sbtree)->y > y)
-    {
-    /* Head into the 'less' sub-tree */
-      add_to_sbtree(entries, &((*sbtree)->less), y);
-    }
-    else
+    memset(count, 0, sizeof(count));
+    for (i= 0; i < n; i++)
+      count[(key[i] >> shift) & ((1 << RADIX_BITS) - 1)]++;
+    if (count[(key[0] >> shift) & ((1 << RADIX_BITS) - 1)] == n)
+      continue;
+    for (d= 0, sum= 0; d < (1 << RADIX_BITS); d++)
     {
-      if ((*sbtree)->y < y)
-      {
-        /* Head into the 'more' sub-tree */
-        add_to_sbtree(entries, &((*sbtree)->more), y);
-      }
+      c= count[d];
+      count[d]= sum;
+      sum+= c;
     }
+    for (i= 0; i < n; i++)
+      tmp[count[(key[i] >> shift) & ((1 << RADIX_BITS) - 1)]++]= key[i];
+    swap= key;
+    key= tmp;
+    tmp= swap;
+  }
+
+  /* Invert the key mapping */
+  for (i= 0; i < n; i++)
+  {
+    key[i]= (key[i] & 0x8000000000000000ULL) ? key[i] & ~0x8000000000000000ULL
+                                             : ~key[i];
+    memcpy(&v[i], &key[i], sizeof(double));
   }
 }
+#else
+static int double_compare(const void *d0, const void *d1)
+{
+  double y0= *(const double *) d0, y1= *(const double *) d1;
+
+  return (y0 < y1) ? -1 : ((y0 > y1) ? 1 : 0);
+}
 
 
-static void build_sbt(int *entries, double *sbt, sb_tree *sbtree)
+static void sort_doubles(node_arena *a, double *v, int n)
 {
-  if (sbtree->less)
-    build_sbt(entries, sbt, sbtree->less);
-  sbt[*entries]= sbtree->y;
-  (*entries)++;
-  if (sbtree->more)
-    build_sbt(entries, sbt, sbtree->more);
+  (void) a;
+  qsort(v, n, sizeof(double), double_compare);
 }
+#endif
 
 
-static void free_sbtree(sb_tree **sbtree)
+static void init_lmt(node_arena *a, lmt_table *lmt, gpc_polygon *subj,
+                     gpc_polygon *clip)
 {
-  if (*sbtree)
-  {
-    free_sbtree(&((*sbtree)->less));
-    free_sbtree(&((*sbtree)->more));
-    FREE(*sbtree);
-  }
+  int c, total_vertices= 0;
+
+  /* Every vertex may add a bound and a scanbeam boundary at most */
+  for (c= 0; c < subj->num_contours; c++)
+    total_vertices+= abs(subj->contour[c].num_vertices);
+  for (c= 0; c < clip->num_contours; c++)
+    total_vertices+= abs(clip->contour[c].num_vertices);
+  ARENA_MALLOC(a, lmt->bound, total_vertices * sizeof(edge_node *),
+               "LMT creation", edge_node *);
+  ARENA_MALLOC(a, lmt->sbt, total_vertices * sizeof(double),
+               "sbt creation", double);
+  lmt->bounds= 0;
+  lmt->sbt_entries= 0;
+}
+
+
+static void sort_lmt(node_arena *a, lmt_table *lmt)
+{
+  int i, n;
+
+  sort_bounds(a, lmt->bound, lmt->bounds);
+
+  /* Sort the scanbeam boundaries and drop the repeated ones */
+  sort_doubles(a, lmt->sbt, lmt->sbt_entries);
+  for (i= 0, n= 0; i < lmt->sbt_entries; i++)
+    if ((n == 0) || (lmt->sbt[i] != lmt->sbt[n - 1]))
+      lmt->sbt[n++]= lmt->sbt[i];
+  lmt->sbt_entries= n;
 }
 
 
@@ -422,9 +532,8 @@ static int count_optimal_vertices(gpc_vertex_list c)
 }
 
 
-static edge_node *build_lmt(lmt_node **lmt, sb_tree **sbtree,
-                            int *sbt_entries, gpc_polygon *p, int type,
-                            gpc_op op)
+static edge_node *build_lmt(node_arena *a, lmt_table *lmt, gpc_polygon *p,
+                            int type, gpc_op op)
 {
   int          c, i, min, max, num_edges, v, num_vertices;
   int          total_vertices= 0, e_index=0;
@@ -434,8 +543,8 @@ static edge_node *build_lmt(lmt_node **lmt, sb_tree **sbtree,
     total_vertices+= count_optimal_vertices(p->contour[c]);
 
   /* Create the entire input polygon edge table in one go */
-  MALLOC(edge_table, total_vertices * sizeof(edge_node),
-         "edge table creation", edge_node);
+  ARENA_MALLOC(a, edge_table, total_vertices * sizeof(edge_node),
+               "edge table creation", edge_node);
 
   for (c= 0; c < p->num_contours; c++)
   {
@@ -455,8 +564,7 @@ static edge_node *build_lmt(lmt_node **lmt, sb_tree **sbtree,
           edge_table[num_vertices].vertex.y= p->contour[c].vertex[i].y;
 
           /* Record vertex in the scanbeam table */
-          add_to_sbtree(sbt_entries, sbtree,
-                        edge_table[num_vertices].vertex.y);
+          lmt->sbt[lmt->sbt_entries++]= edge_table[num_vertices].vertex.y;
 
           num_vertices++;
         }
@@ -503,11 +611,10 @@ static edge_node *build_lmt(lmt_node **lmt, sb_tree **sbtree,
             e[i].succ= ((num_edges > 1) && (i < (num_edges - 1))) ?
                        &(e[i + 1]) : NULL;
             e[i].pred= ((num_edges > 1) && (i > 0)) ? &(e[i - 1]) : NULL;
-            e[i].next_bound= NULL;
             e[i].bside[CLIP]= (op == GPC_DIFF) ? RIGHT : LEFT;
             e[i].bside[SUBJ]= LEFT;
           }
-          insert_bound(bound_list(lmt, edge_table[min].vertex.y), e);
+          lmt->bound[lmt->bounds++]= e;
         }
       }
 
@@ -553,11 +660,10 @@ static edge_node *build_lmt(lmt_node **lmt, sb_tree **sbtree,
             e[i].succ= ((num_edges > 1) && (i < (num_edges - 1))) ?
                        &(e[i + 1]) : NULL;
             e[i].pred= ((num_edges > 1) && (i > 0)) ? &(e[i - 1]) : NULL;
-            e[i].next_bound= NULL;
             e[i].bside[CLIP]= (op == GPC_DIFF) ? RIGHT : LEFT;
             e[i].bside[SUBJ]= LEFT;
           }
-          insert_bound(bound_list(lmt, edge_table[min].vertex.y), e);
+          lmt->bound[lmt->bounds++]= e;
         }
       }
     }
@@ -615,15 +721,47 @@ static void add_edge_to_aet(edge_node **aet, edge_node *edge, edge_node *prev)
 }
 
 
-static void add_intersection(it_node **it, edge_node *edge0, edge_node *edge1,
-                             double x, double y)
+static it_node *new_it_node(node_arena *a)
+{
+  it_node *itn;
+
+  if (a->free_it)
+  {
+    /* Reuse a node released by an earlier scanbeam */
+    itn= a->free_it;
+    a->free_it= itn->next;
+  }
+  else
+    ARENA_MALLOC(a, itn, sizeof(it_node), "IT insertion", it_node);
+  return itn;
+}
+
+
+static st_node *new_st_node(node_arena *a)
+{
+  st_node *stn;
+
+  if (a->free_st)
+  {
+    /* Reuse a node released by an earlier scanbeam */
+    stn= a->free_st;
+    a->free_st= stn->prev;
+  }
+  else
+    ARENA_MALLOC(a, stn, sizeof(st_node), "ST insertion", st_node);
+  return stn;
+}
+
+
+static void add_intersection(node_arena *a, it_node **it, edge_node *edge0,
+                             edge_node *edge1, double x, double y)
 {
   it_node *existing_node;
 
   if (!*it)
   {
     /* Append a new node to the tail of the list */
-    MALLOC(*it, sizeof(it_node), "IT insertion", it_node);
+    *it= new_it_node(a);
     (*it)->ie[0]= edge0;
     (*it)->ie[1]= edge1;
     (*it)->point.x= x;
@@ -636,7 +774,7 @@ static void add_intersection(it_node **it, edge_node *edge0, edge_node *edge1,
     {
       /* Insert a new node mid-list */
       existing_node= *it;
-      MALLOC(*it, sizeof(it_node), "IT insertion", it_node);
+      *it= new_it_node(a);
       (*it)->ie[0]= edge0;
       (*it)->ie[1]= edge1;
       (*it)->point.x= x;
@@ -645,13 +783,13 @@ static void add_intersection(it_node **it, edge_node *edge0, edge_node *edge1,
     }
     else
       /* Head further down the list */
-      add_intersection(&((*it)->next), edge0, edge1, x, y);
+      add_intersection(a, &((*it)->next), edge0, edge1, x, y);
   }
 }
 
 
-static void add_st_edge(st_node **st, it_node **it, edge_node *edge,
-                        double dy)
+static void add_st_edge(node_arena *a, st_node **st, it_node **it,
+                        edge_node *edge, double dy)
 {
   st_node *existing_node;
   double   den, r, x, y;
@@ -659,7 +797,7 @@ static void add_st_edge(st_node **st, it_node **it, edge_node *edge,
   if (!*st)
   {
     /* Append edge onto the tail end of the ST */
-    MALLOC(*st, sizeof(st_node), "ST insertion", st_node);
+    *st= new_st_node(a);
     (*st)->edge= edge;
     (*st)->xb= edge->xb;
     (*st)->xt= edge->xt;
@@ -676,7 +814,7 @@ static void add_st_edge(st_node **st, it_node **it, edge_node *edge,
     {
       /* No intersection - insert edge here (before the ST edge) */
       existing_node= *st;
-      MALLOC(*st, sizeof(st_node), "ST insertion", st_node);
+      *st= new_st_node(a);
       (*st)->edge= edge;
       (*st)->xb= edge->xb;
       (*st)->xt= edge->xt;
@@ -691,22 +829,166 @@ static void add_st_edge(st_node **st, it_node **it, edge_node *edge,
       y= r * dy;
 
       /* Insert the edge pointers and the intersection point in the IT */
-      add_intersection(it, (*st)->edge, edge, x, y);
+      add_intersection(a, it, (*st)->edge, edge, x, y);
 
       /* Head further into the ST */
-      add_st_edge(&((*st)->prev), it, edge, dy);
+      add_st_edge(a, &((*st)->prev), it, edge, dy);
     }
   }
 }
 
 
-static void build_intersection_table(it_node **it, edge_node *aet, double dy)
+static int crossing_compare(const void *c0, const void *c1)
+{
+  const crossing *x0= (const crossing *) c0, *x1= (const crossing *) c1;
+
+  /* Order of the IT insertions: y, then second edge, then ST position */
+  if (x0->point.y != x1->point.y)
+    return (x0->point.y < x1->point.y) ? -1 : 1;
+  if (x0->e[1] != x1->e[1])
+    return x0->e[1] - x1->e[1];
+  return x0->rank - x1->rank;
+}
+
+
+static int find_crossings(node_arena *a, int first, int n, double dy, int *nx)
+{
+  st_node *st= a->st_table, *s0, *s1;
+  int     *src, *dst, *swap;
+  int      width, lo, mid, hi, i, j, k, l;
+  double   den, r;
+
+  /* Stable merge sort by xt: the pairs it inverts are the crossings */
+  src= a->st_order;
+  dst= a->st_order + n;
+  for (i= 0; i < n; i++)
+    src[i]= first + i;
+  *nx= 0;
+  for (width= 1; width < n; width*= 2)
+  {
+    for (lo= 0; lo < n; lo+= 2 * width)
+    {
+      mid= (lo + width < n) ? lo + width : n;
+      hi= (lo + 2 * width < n) ? lo + 2 * width : n;
+      for (i= lo, j= mid, k= lo; k < hi; k++)
+      {
+        if ((j < hi) && ((i == mid) || (st[src[j]].xt < st[src[i]].xt)))
+        {
+          /* Edge src[j] crosses every edge left in the lower run */
+          a->x_table= (crossing *) arena_grow(a, a->x_table, &a->x_size,
+                                              *nx, *nx + mid - i,
+                                              sizeof(crossing));
+          for (l= i; l < mid; l++)
+          {
+            s0= &st[src[l]];
+            s1= &st[src[j]];
+            den= (s0->xt - s0->xb) - (s1->xt - s1->xb);
+
+            /* Leave parallel edges to the sequential ST insertion */
+            if ((s1->dx == s0->dx) || (fabs(den) <= DBL_EPSILON))
+              return FALSE;
+
+            r= (s1->xb - s0->xb) / den;
+            a->x_table[*nx].e[0]= src[l];
+            a->x_table[*nx].e[1]= src[j];
+            a->x_table[*nx].point.x= s0->xb + r * (s0->xt - s0->xb);
+            a->x_table[*nx].point.y= r * dy;
+            (*nx)++;
+          }
+          dst[k]= src[j++];
+        }
+        else
+          dst[k]= src[i++];
+      }
+    }
+    swap= src;
+    src= dst;
+    dst= swap;
+  }
+
+  /* The ST keeps its edges by decreasing xt, the latest edge first */
+  for (k= 0; k < n; k++)
+    dst[src[k] - first]= n - 1 - k;
+  for (i= 0; i < *nx; i++)
+    a->x_table[i].rank= dst[a->x_table[i].e[0] - first];
+  return TRUE;
+}
+
+
+static void build_intersection_table(node_arena *a, it_node **it,
+                                     edge_node *aet, double dy)
 {
   st_node   *st, *stp;
   edge_node *edge;
+  it_node  **tail;
+  int        n, nx, i, lo, hi;
+  double     xt;
 
   /* Build intersection table for the current scanbeam */
-  reset_it(it);
+  reset_it(a, it);
+
+  /* Gather the contributing AET edges into the sorted edge table */
+  n= 0;
+  lo= -1;
+  hi= -1;
+  for (edge= aet; edge; edge= edge->next)
+  {
+    if ((edge->bstate[ABOVE] == BUNDLE_HEAD) ||
+         edge->bundle[ABOVE][CLIP] || edge->bundle[ABOVE][SUBJ])
+    {
+      a->st_table= (st_node *) arena_grow(a, a->st_table, &a->st_size, n,
+                                          n + 1, sizeof(st_node));
+      a->st_table[n].edge= edge;
+      a->st_table[n].xb= edge->xb;
+      a->st_table[n].xt= edge->xt;
+      a->st_table[n].dx= edge->dx;
+      if ((n > 0) && (edge->xt < a->st_table[n - 1].xt))
+      {
+        /* Record the first and the last pair out of order */
+        if (lo < 0)
+          lo= n - 1;
+        hi= n;
+      }
+      n++;
+    }
+  }
+
+  /* Edges that keep their order do not cross within the scanbeam */
+  if (lo < 0)
+    return;
+
+  /* Restrict the search to the edges that cross some other edge */
+  for (xt= a->st_table[lo + 1].xt, i= lo + 2; i < n; i++)
+    if (a->st_table[i].xt < xt)
+      xt= a->st_table[i].xt;
+  while ((lo > 0) && (a->st_table[lo - 1].xt > xt))
+    lo--;
+  for (xt= a->st_table[hi - 1].xt, i= hi - 2; i >= 0; i--)
+    if (a->st_table[i].xt > xt)
+      xt= a->st_table[i].xt;
+  while ((hi < n - 1) && (a->st_table[hi + 1].xt < xt))
+    hi++;
+
+  a->st_order= (int *) arena_grow(a, a->st_order, &a->order_size, 0,
+                                  2 * (hi - lo + 1), sizeof(int));
+  if (find_crossings(a, lo, hi - lo + 1, dy, &nx))
+  {
+    /* Link the crossings, sorted by y, into the intersection table */
+    qsort(a->x_table, nx, sizeof(crossing), crossing_compare);
+    tail= it;
+    for (i= 0; i < nx; i++)
+    {
+      *tail= new_it_node(a);
+      (*tail)->ie[0]= a->st_table[a->x_table[i].e[0]].edge;
+      (*tail)->ie[1]= a->st_table[a->x_table[i].e[1]].edge;
+      (*tail)->point= a->x_table[i].point;
+      tail= &((*tail)->next);
+    }
+    *tail= NULL;
+    return;
+  }
+
+  /* Parallel crossing edges: fall back to sequential ST insertion */
   st= NULL;
 
   /* Process each AET edge */
@@ -714,22 +996,22 @@ static void build_intersection_table(it_node **it, edge_node *aet, double dy)
   {
     if ((edge->bstate[ABOVE] == BUNDLE_HEAD) ||
          edge->bundle[ABOVE][CLIP] || edge->bundle[ABOVE][SUBJ])
-      add_st_edge(&st, it, edge, dy);
+      add_st_edge(a, &st, it, edge, dy);
   }
 
-  /* Free the sorted edge table */
-  while (st)
+  /* Hand the sorted edge table over to the arena for reuse */
+  if (st)
   {
-    stp= st->prev;
-    FREE(st);
-    st= stp;
+    for (stp= st; stp->prev; stp= stp->prev);
+    stp->prev= a->free_st;
+    a->free_st= st;
   }
 }
 
 static int count_contours(polygon_node *polygon)
 {
   int          nc, nv;
-  vertex_node *v, *nextv;
+  vertex_node *v;
 
   for (nc= 0; polygon; polygon= polygon->next)
     if (polygon->active)
@@ -746,26 +1028,20 @@ static int count_contours(polygon_node *polygon)
         nc++;
       }
       else
-      {
-        /* Invalid contour: just free the heap */
-        for (v= polygon->proxy->v[LEFT]; v; v= nextv)
-        {
-          nextv= v->next;
-          FREE(v);
-        }
+        /* Invalid contour: its nodes go with the arena */
         polygon->active= 0;
-      }
     }
   return nc;
 }
 
 
-static void add_left(polygon_node *p, double x, double y)
+static void add_left(node_arena *a, polygon_node *p, double x, double y)
 {
   vertex_node *nv;
 
   /* Create a new vertex node and set its fields */
-  MALLOC(nv, sizeof(vertex_node), "vertex node creation", vertex_node);
+  ARENA_MALLOC(a, nv, sizeof(vertex_node), "vertex node creation",
+               vertex_node);
   nv->x= x;
   nv->y= y;
 
@@ -804,12 +1080,13 @@ static void merge_left(polygon_node *p, polygon_node *q, polygon_node *list)
 }
 
 
-static void add_right(polygon_node *p, double x, double y)
+static void add_right(node_arena *a, polygon_node *p, double x, double y)
 {
   vertex_node *nv;
 
   /* Create a new vertex node and set its fields */
-  MALLOC(nv, sizeof(vertex_node), "vertex node creation", vertex_node);
+  ARENA_MALLOC(a, nv, sizeof(vertex_node), "vertex node creation",
+               vertex_node);
   nv->x= x;
   nv->y= y;
   nv->next= NULL;
@@ -848,7 +1125,7 @@ static void merge_right(polygon_node *p, polygon_node *q, polygon_node *list)
 }
 
 
-static void add_local_min(polygon_node **p, edge_node *edge,
+static void add_local_min(node_arena *a, polygon_node **p, edge_node *edge,
                           double x, double y)
 {
   polygon_node *existing_min;
@@ -856,10 +1133,12 @@ static void add_local_min(polygon_node **p, edge_node *edge,
 
   existing_min= *p;
 
-  MALLOC(*p, sizeof(polygon_node), "polygon node creation", polygon_node);
+  ARENA_MALLOC(a, *p, sizeof(polygon_node), "polygon node creation",
+               polygon_node);
 
   /* Create a new vertex node and set its fields */
-  MALLOC(nv, sizeof(vertex_node), "vertex node creation", vertex_node);
+  ARENA_MALLOC(a, nv, sizeof(vertex_node), "vertex node creation",
+               vertex_node);
   nv->x= x;
   nv->y= y;
   nv->next= NULL;
@@ -889,37 +1168,39 @@ static int count_tristrips(polygon_node *tn)
 }
 
 
-static void add_vertex(vertex_node **t, double x, double y)
+static void add_vertex(node_arena *a, vertex_node **t, double x, double y)
 {
   if (!(*t))
   {
-    MALLOC(*t, sizeof(vertex_node), "tristrip vertex creation", vertex_node);
+    ARENA_MALLOC(a, *t, sizeof(vertex_node), "tristrip vertex creation",
+                 vertex_node);
     (*t)->x= x;
     (*t)->y= y;
     (*t)->next= NULL;
   }
   else
     /* Head further down the list */
-    add_vertex(&((*t)->next), x, y);
+    add_vertex(a, &((*t)->next), x, y);
 }
 
 
-static void new_tristrip(polygon_node **tn, edge_node *edge,
+static void new_tristrip(node_arena *a, polygon_node **tn, edge_node *edge,
                          double x, double y)
 {
   if (!(*tn))
   {
-    MALLOC(*tn, sizeof(polygon_node), "tristrip node creation", polygon_node);
+    ARENA_MALLOC(a, *tn, sizeof(polygon_node), "tristrip node creation",
+                 polygon_node);
     (*tn)->next= NULL;
     (*tn)->v[LEFT]= NULL;
     (*tn)->v[RIGHT]= NULL;
     (*tn)->active= 1;
-    add_vertex(&((*tn)->v[LEFT]), x, y); 
+    add_vertex(a, &((*tn)->v[LEFT]), x, y); 
     edge->outp[ABOVE]= *tn;
   }
   else
     /* Head further down the list */
-    new_tristrip(&((*tn)->next), edge, x, y);
+    new_tristrip(a, &((*tn)->next), edge, x, y);
 }
 
 
@@ -1009,137 +1290,25 @@ static void minimax_test(gpc_polygon *subj, gpc_polygon *clip, gpc_op op)
 }
 
 
-/*
-===========================================================================
-                             Public Functions
-===========================================================================
-*/
-
-void gpc_free_polygon(gpc_polygon *p)
-{
-  int c;
-
-  for (c= 0; c < p->num_contours; c++)
-    FREE(p->contour[c].vertex);
-  FREE(p->hole);
-  FREE(p->contour);
-  p->num_contours= 0;
-}
-
-
-void gpc_read_polygon(FILE *fp, int read_hole_flags, gpc_polygon *p)
-{
-  int c, v;
-
-  fscanf(fp, "%d", &(p->num_contours));
-  MALLOC(p->hole, p->num_contours * sizeof(int),
-         "hole flag array creation", int);
-  MALLOC(p->contour, p->num_contours
-         * sizeof(gpc_vertex_list), "contour creation", gpc_vertex_list);
-  for (c= 0; c < p->num_contours; c++)
-  {
-    fscanf(fp, "%d", &(p->contour[c].num_vertices));
-
-    if (read_hole_flags)
-      fscanf(fp, "%d", &(p->hole[c]));
-    else
-      p->hole[c]= FALSE; /* Assume all contours to be external */
-
-    MALLOC(p->contour[c].vertex, p->contour[c].num_vertices
-           * sizeof(gpc_vertex), "vertex creation", gpc_vertex);
-    for (v= 0; v < p->contour[c].num_vertices; v++)
-      fscanf(fp, "%lf %lf", &(p->contour[c].vertex[v].x),
-                            &(p->contour[c].vertex[v].y));
-  }
-}
-
-
-void gpc_write_polygon(FILE *fp, int write_hole_flags, gpc_polygon *p)
-{
-  int c, v;
-
-  fprintf(fp, "%d\n", p->num_contours);
-  for (c= 0; c < p->num_contours; c++)
-  {
-    fprintf(fp, "%d\n", p->contour[c].num_vertices);
-
-    if (write_hole_flags)
-      fprintf(fp, "%d\n", p->hole[c]);
-    
-    for (v= 0; v < p->contour[c].num_vertices; v++)
-      fprintf(fp, "% .*lf % .*lf\n",
-              DBL_DIG, p->contour[c].vertex[v].x,
-              DBL_DIG, p->contour[c].vertex[v].y);
-  }
-}
-
-
-void gpc_add_contour(gpc_polygon *p, gpc_vertex_list *new_contour, int hole)
-{
-  int             *extended_hole, c, v;
-  gpc_vertex_list *extended_contour;
-
-  /* Create an extended hole array */
-  MALLOC(extended_hole, (p->num_contours + 1)
-         * sizeof(int), "contour hole addition", int);
-
-  /* Create an extended contour array */
-  MALLOC(extended_contour, (p->num_contours + 1)
-         * sizeof(gpc_vertex_list), "contour addition", gpc_vertex_list);
-
-  /* Copy the old contour and hole data into the extended arrays */
-  for (c= 0; c < p->num_contours; c++)
-  {
-    extended_hole[c]= p->hole[c];
-    extended_contour[c]= p->contour[c];
-  }
-
-  /* Copy the new contour and hole onto the end of the extended arrays */
-  c= p->num_contours;
-  extended_hole[c]= hole;
-  extended_contour[c].num_vertices= new_contour->num_vertices;
-  MALLOC(extended_contour[c].vertex, new_contour->num_vertices
-         * sizeof(gpc_vertex), "contour addition", gpc_vertex);
-  for (v= 0; v < new_contour->num_vertices; v++)
-    extended_contour[c].vertex[v]= new_contour->vertex[v];
-
-  /* Dispose of the old contour */
-  FREE(p->contour);
-  FREE(p->hole);
-
-  /* Update the polygon information */
-  p->num_contours++;
-  p->hole= extended_hole;
-  p->contour= extended_contour;
-}
-
-
-void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
-                      gpc_polygon *result)
+static polygon_node *polygon_clip(node_arena *a, gpc_op op, gpc_polygon *subj,
+                                  gpc_polygon *clip)
 {
-  sb_tree       *sbtree= NULL;
   it_node       *it= NULL, *intersect;
   edge_node     *edge, *prev_edge, *next_edge, *succ_edge, *e0, *e1;
-  edge_node     *aet= NULL, *c_heap= NULL, *s_heap= NULL;
-  lmt_node      *lmt= NULL, *local_min;
-  polygon_node  *out_poly= NULL, *p, *q, *poly, *npoly, *cf= NULL;
-  vertex_node   *vtx, *nv;
+  edge_node     *aet= NULL;
+  lmt_table      lmt;
+  polygon_node  *out_poly= NULL, *p, *q, *cf= NULL;
   h_state        horiz[2];
   int            in[2], exists[2], parity[2]= {LEFT, LEFT};
-  int            c, v, contributing, search, scanbeam= 0, sbt_entries= 0;
-  int            vclass, bl, br, tl, tr;
-  double        *sbt= NULL, xb, px, yb, yt, dy, ix, iy;
+  int            contributing, search, scanbeam= 0, sbt_entries;
+  int            vclass, bl, br, tl, tr, local_min= 0;
+  double        *sbt, xb, px, yb, yt, dy, ix, iy;
 
   /* Test for trivial NULL result cases */
   if (((subj->num_contours == 0) && (clip->num_contours == 0))
    || ((subj->num_contours == 0) && ((op == GPC_INT) || (op == GPC_DIFF)))
    || ((clip->num_contours == 0) &&  (op == GPC_INT)))
-  {
-    result->num_contours= 0;
-    result->hole= NULL;
-    result->contour= NULL;
-    return;
-  }
+    return NULL;
 
   /* Identify potentialy contributing contours */
   if (((op == GPC_INT) || (op == GPC_DIFF))
@@ -1147,41 +1316,25 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
     minimax_test(subj, clip, op);
 
   /* Build LMT */
+  init_lmt(a, &lmt, subj, clip);
   if (subj->num_contours > 0)
-    s_heap= build_lmt(&lmt, &sbtree, &sbt_entries, subj, SUBJ, op);
+    build_lmt(a, &lmt, subj, SUBJ, op);
   if (clip->num_contours > 0)
-    c_heap= build_lmt(&lmt, &sbtree, &sbt_entries, clip, CLIP, op);
+    build_lmt(a, &lmt, clip, CLIP, op);
 
   /* Return a NULL result if no contours contribute */
-  if (lmt == NULL)
-  {
-    result->num_contours= 0;
-    result->hole= NULL;
-    result->contour= NULL;
-    reset_lmt(&lmt);
-    FREE(s_heap);
-    FREE(c_heap);
-    return;
-  }
+  if (lmt.bounds == 0)
+    return NULL;
 
-  /* Build scanbeam table from scanbeam tree */
-  MALLOC(sbt, sbt_entries * sizeof(double), "sbt creation", double);
-  build_sbt(&scanbeam, sbt, sbtree);
-  scanbeam= 0;
-  free_sbtree(&sbtree);
-
-  /* Allow pointer re-use without causing memory leak */
-  if (subj == result)
-    gpc_free_polygon(subj);
-  if (clip == result)
-    gpc_free_polygon(clip);
+  /* Sort the LMT and the scanbeam table */
+  sort_lmt(a, &lmt);
+  sbt= lmt.sbt;
+  sbt_entries= lmt.sbt_entries;
 
   /* Invert clip polygon for difference operation */
   if (op == GPC_DIFF)
     parity[CLIP]= RIGHT;
 
-  local_min= lmt;
-
   /* Process each scanbeam */
   while (scanbeam < sbt_entries)
   {
@@ -1195,18 +1348,9 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
 
     /* === SCANBEAM BOUNDARY PROCESSING ================================ */
 
-    /* If LMT node corresponding to yb exists */
-    if (local_min)
-    {
-      if (local_min->y == yb)
-      {
-        /* Add edges starting at this local minimum to the AET */
-        for (edge= local_min->first_bound; edge; edge= edge->next_bound)
-          add_edge_to_aet(&aet, edge, NULL);
-
-        local_min= local_min->next;
-      }
-    }
+    /* Add edges starting at a local minimum at yb to the AET */
+    while ((local_min < lmt.bounds) && (lmt.bound[local_min]->bot.y == yb))
+      add_edge_to_aet(&aet, lmt.bound[local_min++], NULL);
 
     /* Set dummy previous x value */
     px= -DBL_MAX;
@@ -1332,28 +1476,28 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           {
           case EMN:
           case IMN:
-            add_local_min(&out_poly, edge, xb, yb);
+            add_local_min(a, &out_poly, edge, xb, yb);
             px= xb;
             cf= edge->outp[ABOVE];
             break;
           case ERI:
             if (xb != px)
             {
-              add_right(cf, xb, yb);
+              add_right(a, cf, xb, yb);
               px= xb;
             }
             edge->outp[ABOVE]= cf;
             cf= NULL;
             break;
           case ELI:
-            add_left(edge->outp[BELOW], xb, yb);
+            add_left(a, edge->outp[BELOW], xb, yb);
             px= xb;
             cf= edge->outp[BELOW];
             break;
           case EMX:
             if (xb != px)
             {
-              add_left(cf, xb, yb);
+              add_left(a, cf, xb, yb);
               px= xb;
             }
             merge_right(cf, edge->outp[BELOW], out_poly);
@@ -1362,14 +1506,14 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           case ILI:
             if (xb != px)
             {
-              add_left(cf, xb, yb);
+              add_left(a, cf, xb, yb);
               px= xb;
             }
             edge->outp[ABOVE]= cf;
             cf= NULL;
             break;
           case IRI:
-            add_right(edge->outp[BELOW], xb, yb);
+            add_right(a, edge->outp[BELOW], xb, yb);
             px= xb;
             cf= edge->outp[BELOW];
             edge->outp[BELOW]= NULL;
@@ -1377,7 +1521,7 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           case IMX:
             if (xb != px)
             {
-              add_right(cf, xb, yb);
+              add_right(a, cf, xb, yb);
               px= xb;
             }
             merge_left(cf, edge->outp[BELOW], out_poly);
@@ -1387,34 +1531,34 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           case IMM:
             if (xb != px)
 	    {
-              add_right(cf, xb, yb);
+              add_right(a, cf, xb, yb);
               px= xb;
 	    }
             merge_left(cf, edge->outp[BELOW], out_poly);
             edge->outp[BELOW]= NULL;
-            add_local_min(&out_poly, edge, xb, yb);
+            add_local_min(a, &out_poly, edge, xb, yb);
             cf= edge->outp[ABOVE];
             break;
           case EMM:
             if (xb != px)
 	    {
-              add_left(cf, xb, yb);
+              add_left(a, cf, xb, yb);
               px= xb;
 	    }
             merge_right(cf, edge->outp[BELOW], out_poly);
             edge->outp[BELOW]= NULL;
-            add_local_min(&out_poly, edge, xb, yb);
+            add_local_min(a, &out_poly, edge, xb, yb);
             cf= edge->outp[ABOVE];
             break;
           case LED:
             if (edge->bot.y == yb)
-              add_left(edge->outp[BELOW], xb, yb);
+              add_left(a, edge->outp[BELOW], xb, yb);
             edge->outp[ABOVE]= edge->outp[BELOW];
             px= xb;
             break;
           case RED:
             if (edge->bot.y == yb)
-              add_right(edge->outp[BELOW], xb, yb);
+              add_right(a, edge->outp[BELOW], xb, yb);
             edge->outp[ABOVE]= edge->outp[BELOW];
             px= xb;
             break;
@@ -1465,7 +1609,7 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
     {
       /* === SCANBEAM INTERIOR PROCESSING ============================== */
 
-      build_intersection_table(&it, aet, dy);
+      build_intersection_table(a, &it, aet, dy);
 
       /* Process each node in the intersection table */
       for (intersect= it; intersect; intersect= intersect->next)
@@ -1532,13 +1676,13 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           switch (vclass)
           {
           case EMN:
-            add_local_min(&out_poly, e0, ix, iy);
+            add_local_min(a, &out_poly, e0, ix, iy);
             e1->outp[ABOVE]= e0->outp[ABOVE];
             break;
           case ERI:
             if (p)
             {
-              add_right(p, ix, iy);
+              add_right(a, p, ix, iy);
               e1->outp[ABOVE]= p;
               e0->outp[ABOVE]= NULL;
             }
@@ -1546,7 +1690,7 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           case ELI:
             if (q)
             {
-              add_left(q, ix, iy);
+              add_left(a, q, ix, iy);
               e0->outp[ABOVE]= q;
               e1->outp[ABOVE]= NULL;
             }
@@ -1554,20 +1698,20 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           case EMX:
             if (p && q)
             {
-              add_left(p, ix, iy);
+              add_left(a, p, ix, iy);
               merge_right(p, q, out_poly);
               e0->outp[ABOVE]= NULL;
               e1->outp[ABOVE]= NULL;
             }
             break;
           case IMN:
-            add_local_min(&out_poly, e0, ix, iy);
+            add_local_min(a, &out_poly, e0, ix, iy);
             e1->outp[ABOVE]= e0->outp[ABOVE];
             break;
           case ILI:
             if (p)
             {
-              add_left(p, ix, iy);
+              add_left(a, p, ix, iy);
               e1->outp[ABOVE]= p;
               e0->outp[ABOVE]= NULL;
             }
@@ -1575,7 +1719,7 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           case IRI:
             if (q)
             {
-              add_right(q, ix, iy);
+              add_right(a, q, ix, iy);
               e0->outp[ABOVE]= q;
               e1->outp[ABOVE]= NULL;
             }
@@ -1583,7 +1727,7 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           case IMX:
             if (p && q)
             {
-              add_right(p, ix, iy);
+              add_right(a, p, ix, iy);
               merge_left(p, q, out_poly);
               e0->outp[ABOVE]= NULL;
               e1->outp[ABOVE]= NULL;
@@ -1592,18 +1736,18 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           case IMM:
             if (p && q)
             {
-              add_right(p, ix, iy);
+              add_right(a, p, ix, iy);
               merge_left(p, q, out_poly);
-              add_local_min(&out_poly, e0, ix, iy);
+              add_local_min(a, &out_poly, e0, ix, iy);
               e1->outp[ABOVE]= e0->outp[ABOVE];
             }
             break;
           case EMM:
             if (p && q)
             {
-              add_left(p, ix, iy);
+              add_left(a, p, ix, iy);
               merge_right(p, q, out_poly);
-              add_local_min(&out_poly, e0, ix, iy);
+              add_local_min(a, &out_poly, e0, ix, iy);
               e1->outp[ABOVE]= e0->outp[ABOVE];
             }
             break;
@@ -1697,6 +1841,133 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
     }
   } /* === END OF SCANBEAM PROCESSING ================================== */
 
+  return out_poly;
+}
+
+
+/*
+===========================================================================
+                             Public Functions
+===========================================================================
+*/
+
+void gpc_free_polygon(gpc_polygon *p)
+{
+  int c;
+
+  for (c= 0; c < p->num_contours; c++)
+    FREE(p->contour[c].vertex);
+  FREE(p->hole);
+  FREE(p->contour);
+  p->num_contours= 0;
+}
+
+
+void gpc_read_polygon(FILE *fp, int read_hole_flags, gpc_polygon *p)
+{
+  int c, v;
+
+  fscanf(fp, "%d", &(p->num_contours));
+  MALLOC(p->hole, p->num_contours * sizeof(int),
+         "hole flag array creation", int);
+  MALLOC(p->contour, p->num_contours
+         * sizeof(gpc_vertex_list), "contour creation", gpc_vertex_list);
+  for (c= 0; c < p->num_contours; c++)
+  {
+    fscanf(fp, "%d", &(p->contour[c].num_vertices));
+
+    if (read_hole_flags)
+      fscanf(fp, "%d", &(p->hole[c]));
+    else
+      p->hole[c]= FALSE; /* Assume all contours to be external */
+
+    MALLOC(p->contour[c].vertex, p->contour[c].num_vertices
+           * sizeof(gpc_vertex), "vertex creation", gpc_vertex);
+    for (v= 0; v < p->contour[c].num_vertices; v++)
+      fscanf(fp, "%lf %lf", &(p->contour[c].vertex[v].x),
+                            &(p->contour[c].vertex[v].y));
+  }
+}
+
+
+void gpc_write_polygon(FILE *fp, int write_hole_flags, gpc_polygon *p)
+{
+  int c, v;
+
+  fprintf(fp, "%d\n", p->num_contours);
+  for (c= 0; c < p->num_contours; c++)
+  {
+    fprintf(fp, "%d\n", p->contour[c].num_vertices);
+
+    if (write_hole_flags)
+      fprintf(fp, "%d\n", p->hole[c]);
+    
+    for (v= 0; v < p->contour[c].num_vertices; v++)
+      fprintf(fp, "% .*lf % .*lf\n",
+              DBL_DIG, p->contour[c].vertex[v].x,
+              DBL_DIG, p->contour[c].vertex[v].y);
+  }
+}
+
+
+void gpc_add_contour(gpc_polygon *p, gpc_vertex_list *new_contour, int hole)
+{
+  int             *extended_hole, c, v;
+  gpc_vertex_list *extended_contour;
+
+  /* Create an extended hole array */
+  MALLOC(extended_hole, (p->num_contours + 1)
+         * sizeof(int), "contour hole addition", int);
+
+  /* Create an extended contour array */
+  MALLOC(extended_contour, (p->num_contours + 1)
+         * sizeof(gpc_vertex_list), "contour addition", gpc_vertex_list);
+
+  /* Copy the old contour and hole data into the extended arrays */
+  for (c= 0; c < p->num_contours; c++)
+  {
+    extended_hole[c]= p->hole[c];
+    extended_contour[c]= p->contour[c];
+  }
+
+  /* Copy the new contour and hole onto the end of the extended arrays */
+  c= p->num_contours;
+  extended_hole[c]= hole;
+  extended_contour[c].num_vertices= new_contour->num_vertices;
+  MALLOC(extended_contour[c].vertex, new_contour->num_vertices
+         * sizeof(gpc_vertex), "contour addition", gpc_vertex);
+  for (v= 0; v < new_contour->num_vertices; v++)
+    extended_contour[c].vertex[v]= new_contour->vertex[v];
+
+  /* Dispose of the old contour */
+  FREE(p->contour);
+  FREE(p->hole);
+
+  /* Update the polygon information */
+  p->num_contours++;
+  p->hole= extended_hole;
+  p->contour= extended_contour;
+}
+
+
+void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
+                      gpc_polygon *result)
+{
+  node_arena     arena;
+  polygon_node  *out_poly, *poly, *npoly;
+  vertex_node   *vtx, *nv;
+  int            c, v;
+
+  /* All scratch nodes of this call come from the arena */
+  init_arena(&arena);
+  out_poly= polygon_clip(&arena, op, subj, clip);
+
+  /* Allow pointer re-use without causing memory leak */
+  if (subj == result)
+    gpc_free_polygon(subj);
+  if (clip == result)
+    gpc_free_polygon(clip);
+
   /* Generate result polygon from out_poly */
   result->contour= NULL;
   result->hole= NULL;
@@ -1726,29 +1997,15 @@ void gpc_polygon_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           nv= vtx->next;
           result->contour[c].vertex[v].x= vtx->x;
           result->contour[c].vertex[v].y= vtx->y;
-          FREE(vtx);
           v--;
         }
         c++;
       }
-      FREE(poly);
-    }
-  }
-  else
-  {
-    for (poly= out_poly; poly; poly= npoly)
-    {
-      npoly= poly->next;
-      FREE(poly);
     }
   }
 
   /* Tidy up */
-  reset_it(&it);
-  reset_lmt(&lmt);
-  FREE(c_heap);
-  FREE(s_heap);
-  FREE(sbt);
+  release_arena(&arena);
 }
 
 
@@ -1777,19 +2034,19 @@ void gpc_polygon_to_tristrip(gpc_polygon *s, gpc_tristrip *t)
 void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
                        gpc_tristrip *result)
 {
-  sb_tree       *sbtree= NULL;
+  node_arena     arena;
   it_node       *it= NULL, *intersect;
   edge_node     *edge, *prev_edge, *next_edge, *succ_edge, *e0, *e1;
-  edge_node     *aet= NULL, *c_heap= NULL, *s_heap= NULL, *cf;
-  lmt_node      *lmt= NULL, *local_min;
+  edge_node     *aet= NULL, *cf;
+  lmt_table      lmt;
   polygon_node  *tlist= NULL, *tn, *tnn, *p, *q;
   vertex_node   *lt, *ltn, *rt, *rtn;
   h_state        horiz[2];
   vertex_type    cft;
   int            in[2], exists[2], parity[2]= {LEFT, LEFT};
-  int            s, v, contributing, search, scanbeam= 0, sbt_entries= 0;
-  int            vclass, bl, br, tl, tr;
-  double        *sbt= NULL, xb, px, nx, yb, yt, dy, ix, iy;
+  int            s, v, contributing, search, scanbeam= 0, sbt_entries;
+  int            vclass, bl, br, tl, tr, local_min= 0;
+  double        *sbt, xb, px, nx, yb, yt, dy, ix, iy;
 
   /* Test for trivial NULL result cases */
   if (((subj->num_contours == 0) && (clip->num_contours == 0))
@@ -1806,35 +2063,34 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
    && (subj->num_contours > 0) && (clip->num_contours > 0))
     minimax_test(subj, clip, op);
 
+  /* All scratch nodes of this call come from the arena */
+  init_arena(&arena);
+
   /* Build LMT */
+  init_lmt(&arena, &lmt, subj, clip);
   if (subj->num_contours > 0)
-    s_heap= build_lmt(&lmt, &sbtree, &sbt_entries, subj, SUBJ, op);
+    build_lmt(&arena, &lmt, subj, SUBJ, op);
   if (clip->num_contours > 0)
-    c_heap= build_lmt(&lmt, &sbtree, &sbt_entries, clip, CLIP, op);
+    build_lmt(&arena, &lmt, clip, CLIP, op);
 
   /* Return a NULL result if no contours contribute */
-  if (lmt == NULL)
+  if (lmt.bounds == 0)
   {
     result->num_strips= 0;
     result->strip= NULL;
-    reset_lmt(&lmt);
-    FREE(s_heap);
-    FREE(c_heap);
+    release_arena(&arena);
     return;
   }
 
-  /* Build scanbeam table from scanbeam tree */
-  MALLOC(sbt, sbt_entries * sizeof(double), "sbt creation", double);
-  build_sbt(&scanbeam, sbt, sbtree);
-  scanbeam= 0;
-  free_sbtree(&sbtree);
+  /* Sort the LMT and the scanbeam table */
+  sort_lmt(&arena, &lmt);
+  sbt= lmt.sbt;
+  sbt_entries= lmt.sbt_entries;
 
   /* Invert clip polygon for difference operation */
   if (op == GPC_DIFF)
     parity[CLIP]= RIGHT;
 
-  local_min= lmt;
-
   /* Process each scanbeam */
   while (scanbeam < sbt_entries)
   {
@@ -1848,18 +2104,9 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
 
     /* === SCANBEAM BOUNDARY PROCESSING ================================ */
 
-    /* If LMT node corresponding to yb exists */
-    if (local_min)
-    {
-      if (local_min->y == yb)
-      {
-        /* Add edges starting at this local minimum to the AET */
-        for (edge= local_min->first_bound; edge; edge= edge->next_bound)
-          add_edge_to_aet(&aet, edge, NULL);
-
-        local_min= local_min->next;
-      }
-    }
+    /* Add edges starting at a local minimum at yb to the AET */
+    while ((local_min < lmt.bounds) && (lmt.bound[local_min]->bot.y == yb))
+      add_edge_to_aet(&aet, lmt.bound[local_min++], NULL);
 
     /* Set dummy previous x value */
     px= -DBL_MAX;
@@ -1984,23 +2231,23 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           switch (vclass)
           {
           case EMN:
-            new_tristrip(&tlist, edge, xb, yb);
+            new_tristrip(&arena, &tlist, edge, xb, yb);
             cf= edge;
             break;
           case ERI:
             edge->outp[ABOVE]= cf->outp[ABOVE];
             if (xb != cf->xb)
-              VERTEX(edge, ABOVE, RIGHT, xb, yb);
+              VERTEX(&arena, edge, ABOVE, RIGHT, xb, yb);
             cf= NULL;
             break;
           case ELI:
-            VERTEX(edge, BELOW, LEFT, xb, yb);
+            VERTEX(&arena, edge, BELOW, LEFT, xb, yb);
             edge->outp[ABOVE]= NULL;
             cf= edge;
             break;
           case EMX:
             if (xb != cf->xb)
-              VERTEX(edge, BELOW, RIGHT, xb, yb);
+              VERTEX(&arena, edge, BELOW, RIGHT, xb, yb);
             edge->outp[ABOVE]= NULL;
             cf= NULL;
             break;
@@ -2008,14 +2255,14 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
             if (cft == LED)
 	    {
               if (cf->bot.y != yb)
-                VERTEX(cf, BELOW, LEFT, cf->xb, yb);
-              new_tristrip(&tlist, cf, cf->xb, yb);
+                VERTEX(&arena, cf, BELOW, LEFT, cf->xb, yb);
+              new_tristrip(&arena, &tlist, cf, cf->xb, yb);
 	    }
             edge->outp[ABOVE]= cf->outp[ABOVE];
-            VERTEX(edge, ABOVE, RIGHT, xb, yb);
+            VERTEX(&arena, edge, ABOVE, RIGHT, xb, yb);
             break;
           case ILI:
-            new_tristrip(&tlist, edge, xb, yb);
+            new_tristrip(&arena, &tlist, edge, xb, yb);
             cf= edge;
             cft= ILI;
             break;
@@ -2023,33 +2270,33 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
             if (cft == LED)
 	    {
               if (cf->bot.y != yb)
-                VERTEX(cf, BELOW, LEFT, cf->xb, yb);
-              new_tristrip(&tlist, cf, cf->xb, yb);
+                VERTEX(&arena, cf, BELOW, LEFT, cf->xb, yb);
+              new_tristrip(&arena, &tlist, cf, cf->xb, yb);
 	    }
-            VERTEX(edge, BELOW, RIGHT, xb, yb);
+            VERTEX(&arena, edge, BELOW, RIGHT, xb, yb);
             edge->outp[ABOVE]= NULL;
             break;
           case IMX:
-            VERTEX(edge, BELOW, LEFT, xb, yb);
+            VERTEX(&arena, edge, BELOW, LEFT, xb, yb);
             edge->outp[ABOVE]= NULL;
             cft= IMX;
             break;
 	  case IMM:
-            VERTEX(edge, BELOW, LEFT, xb, yb);
+            VERTEX(&arena, edge, BELOW, LEFT, xb, yb);
             edge->outp[ABOVE]= cf->outp[ABOVE];
             if (xb != cf->xb)
-              VERTEX(cf, ABOVE, RIGHT, xb, yb);
+              VERTEX(&arena, cf, ABOVE, RIGHT, xb, yb);
             cf= edge;
             break;
           case EMM:
-            VERTEX(edge, BELOW, RIGHT, xb, yb);
+            VERTEX(&arena, edge, BELOW, RIGHT, xb, yb);
             edge->outp[ABOVE]= NULL;
-            new_tristrip(&tlist, edge, xb, yb);
+            new_tristrip(&arena, &tlist, edge, xb, yb);
             cf= edge;
             break;
           case LED:
             if (edge->bot.y == yb)
-              VERTEX(edge, BELOW, LEFT, xb, yb);
+              VERTEX(&arena, edge, BELOW, LEFT, xb, yb);
             edge->outp[ABOVE]= edge->outp[BELOW];
             cf= edge;
             cft= LED;
@@ -2060,21 +2307,21 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
 	    {
               if (cf->bot.y == yb)
 	      {
-                VERTEX(edge, BELOW, RIGHT, xb, yb);
+                VERTEX(&arena, edge, BELOW, RIGHT, xb, yb);
 	      }
               else
 	      {
                 if (edge->bot.y == yb)
 		{
-                  VERTEX(cf, BELOW, LEFT, cf->xb, yb);
-                  VERTEX(edge, BELOW, RIGHT, xb, yb);
+                  VERTEX(&arena, cf, BELOW, LEFT, cf->xb, yb);
+                  VERTEX(&arena, edge, BELOW, RIGHT, xb, yb);
 		}
 	      }
 	    }
             else
 	    {
-              VERTEX(edge, BELOW, RIGHT, xb, yb);
-              VERTEX(edge, ABOVE, RIGHT, xb, yb);
+              VERTEX(&arena, edge, BELOW, RIGHT, xb, yb);
+              VERTEX(&arena, edge, ABOVE, RIGHT, xb, yb);
 	    }
             cf= NULL;
             break;
@@ -2125,7 +2372,7 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
     {
       /* === SCANBEAM INTERIOR PROCESSING ============================== */
   
-      build_intersection_table(&it, aet, dy);
+      build_intersection_table(&arena, &it, aet, dy);
 
       /* Process each node in the intersection table */
       for (intersect= it; intersect; intersect= intersect->next)
@@ -2192,15 +2439,15 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           switch (vclass)
           {
           case EMN:
-            new_tristrip(&tlist, e1, ix, iy);
+            new_tristrip(&arena, &tlist, e1, ix, iy);
             e0->outp[ABOVE]= e1->outp[ABOVE];
             break;
           case ERI:
             if (p)
             {
               P_EDGE(prev_edge, e0, ABOVE, px, iy);
-              VERTEX(prev_edge, ABOVE, LEFT, px, iy);
-              VERTEX(e0, ABOVE, RIGHT, ix, iy);
+              VERTEX(&arena, prev_edge, ABOVE, LEFT, px, iy);
+              VERTEX(&arena, e0, ABOVE, RIGHT, ix, iy);
               e1->outp[ABOVE]= e0->outp[ABOVE];
               e0->outp[ABOVE]= NULL;
             }
@@ -2209,8 +2456,8 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
             if (q)
             {
               N_EDGE(next_edge, e1, ABOVE, nx, iy);
-              VERTEX(e1, ABOVE, LEFT, ix, iy);
-              VERTEX(next_edge, ABOVE, RIGHT, nx, iy);
+              VERTEX(&arena, e1, ABOVE, LEFT, ix, iy);
+              VERTEX(&arena, next_edge, ABOVE, RIGHT, nx, iy);
               e0->outp[ABOVE]= e1->outp[ABOVE];
               e1->outp[ABOVE]= NULL;
             }
@@ -2218,29 +2465,29 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           case EMX:
             if (p && q)
             {
-              VERTEX(e0, ABOVE, LEFT, ix, iy);
+              VERTEX(&arena, e0, ABOVE, LEFT, ix, iy);
               e0->outp[ABOVE]= NULL;
               e1->outp[ABOVE]= NULL;
             }
             break;
           case IMN:
             P_EDGE(prev_edge, e0, ABOVE, px, iy);
-            VERTEX(prev_edge, ABOVE, LEFT, px, iy);
+            VERTEX(&arena, prev_edge, ABOVE, LEFT, px, iy);
             N_EDGE(next_edge, e1, ABOVE, nx, iy);
-            VERTEX(next_edge, ABOVE, RIGHT, nx, iy);
-            new_tristrip(&tlist, prev_edge, px, iy); 
+            VERTEX(&arena, next_edge, ABOVE, RIGHT, nx, iy);
+            new_tristrip(&arena, &tlist, prev_edge, px, iy); 
             e1->outp[ABOVE]= prev_edge->outp[ABOVE];
-            VERTEX(e1, ABOVE, RIGHT, ix, iy);
-            new_tristrip(&tlist, e0, ix, iy);
+            VERTEX(&arena, e1, ABOVE, RIGHT, ix, iy);
+            new_tristrip(&arena, &tlist, e0, ix, iy);
             next_edge->outp[ABOVE]= e0->outp[ABOVE];
-            VERTEX(next_edge, ABOVE, RIGHT, nx, iy);
+            VERTEX(&arena, next_edge, ABOVE, RIGHT, nx, iy);
             break;
           case ILI:
             if (p)
             {
-              VERTEX(e0, ABOVE, LEFT, ix, iy);
+              VERTEX(&arena, e0, ABOVE, LEFT, ix, iy);
               N_EDGE(next_edge, e1, ABOVE, nx, iy);
-              VERTEX(next_edge, ABOVE, RIGHT, nx, iy);
+              VERTEX(&arena, next_edge, ABOVE, RIGHT, nx, iy);
               e1->outp[ABOVE]= e0->outp[ABOVE];
               e0->outp[ABOVE]= NULL;
             }
@@ -2248,9 +2495,9 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           case IRI:
             if (q)
             {
-              VERTEX(e1, ABOVE, RIGHT, ix, iy);
+              VERTEX(&arena, e1, ABOVE, RIGHT, ix, iy);
               P_EDGE(prev_edge, e0, ABOVE, px, iy);
-              VERTEX(prev_edge, ABOVE, LEFT, px, iy);
+              VERTEX(&arena, prev_edge, ABOVE, LEFT, px, iy);
               e0->outp[ABOVE]= e1->outp[ABOVE];
               e1->outp[ABOVE]= NULL;
             }
@@ -2258,41 +2505,41 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
           case IMX:
             if (p && q)
             {
-              VERTEX(e0, ABOVE, RIGHT, ix, iy);
-              VERTEX(e1, ABOVE, LEFT, ix, iy);
+              VERTEX(&arena, e0, ABOVE, RIGHT, ix, iy);
+              VERTEX(&arena, e1, ABOVE, LEFT, ix, iy);
               e0->outp[ABOVE]= NULL;
               e1->outp[ABOVE]= NULL;
               P_EDGE(prev_edge, e0, ABOVE, px, iy);
-              VERTEX(prev_edge, ABOVE, LEFT, px, iy);
-              new_tristrip(&tlist, prev_edge, px, iy);
+              VERTEX(&arena, prev_edge, ABOVE, LEFT, px, iy);
+              new_tristrip(&arena, &tlist, prev_edge, px, iy);
               N_EDGE(next_edge, e1, ABOVE, nx, iy);
-              VERTEX(next_edge, ABOVE, RIGHT, nx, iy);
+              VERTEX(&arena, next_edge, ABOVE, RIGHT, nx, iy);
               next_edge->outp[ABOVE]= prev_edge->outp[ABOVE];
-              VERTEX(next_edge, ABOVE, RIGHT, nx, iy);
+              VERTEX(&arena, next_edge, ABOVE, RIGHT, nx, iy);
             }
             break;
           case IMM:
             if (p && q)
             {
-              VERTEX(e0, ABOVE, RIGHT, ix, iy);
-              VERTEX(e1, ABOVE, LEFT, ix, iy);
+              VERTEX(&arena, e0, ABOVE, RIGHT, ix, iy);
+              VERTEX(&arena, e1, ABOVE, LEFT, ix, iy);
               P_EDGE(prev_edge, e0, ABOVE, px, iy);
-              VERTEX(prev_edge, ABOVE, LEFT, px, iy);
-              new_tristrip(&tlist, prev_edge, px, iy);
+              VERTEX(&arena, prev_edge, ABOVE, LEFT, px, iy);
+              new_tristrip(&arena, &tlist, prev_edge, px, iy);
               N_EDGE(next_edge, e1, ABOVE, nx, iy);
-              VERTEX(next_edge, ABOVE, RIGHT, nx, iy);
+              VERTEX(&arena, next_edge, ABOVE, RIGHT, nx, iy);
               e1->outp[ABOVE]= prev_edge->outp[ABOVE];
-              VERTEX(e1, ABOVE, RIGHT, ix, iy);
-              new_tristrip(&tlist, e0, ix, iy);
+              VERTEX(&arena, e1, ABOVE, RIGHT, ix, iy);
+              new_tristrip(&arena, &tlist, e0, ix, iy);
               next_edge->outp[ABOVE]= e0->outp[ABOVE];
-              VERTEX(next_edge, ABOVE, RIGHT, nx, iy);
+              VERTEX(&arena, next_edge, ABOVE, RIGHT, nx, iy);
             }
             break;
           case EMM:
             if (p && q)
             {
-              VERTEX(e0, ABOVE, LEFT, ix, iy);
-              new_tristrip(&tlist, e1, ix, iy);
+              VERTEX(&arena, e0, ABOVE, LEFT, ix, iy);
+              new_tristrip(&arena, &tlist, e1, ix, iy);
               e0->outp[ABOVE]= e1->outp[ABOVE];
             }
             break;
@@ -2424,7 +2671,6 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
             result->strip[s].vertex[v].x= lt->x;
             result->strip[s].vertex[v].y= lt->y;
             v++;
-            FREE(lt);
             lt= ltn;
           }
           if (rt)
@@ -2433,38 +2679,21 @@ void gpc_tristrip_clip(gpc_op op, gpc_polygon *subj, gpc_polygon *clip,
             result->strip[s].vertex[v].x= rt->x;
             result->strip[s].vertex[v].y= rt->y;
             v++;
-            FREE(rt);
             rt= rtn;
           }
         }
         s++;
       }
-      else
-      {
-        /* Invalid tristrip: just free the heap */
-        for (lt= tn->v[LEFT]; lt; lt= ltn)
-        {
-          ltn= lt->next;
-          FREE(lt);
-        }
-        for (rt= tn->v[RIGHT]; rt; rt=rtn)
-        {
-          rtn= rt->next;
-          FREE(rt);
-        }
-      }
-      FREE(tn);
     }
   }
 
   /* Tidy up */
-  reset_it(&it);
-  reset_lmt(&lmt);
-  FREE(c_heap);
-  FREE(s_heap);
-  FREE(sbt);
+  release_arena(&arena);
 }
 
+/* A Point is laid out as a gpc_vertex, so contours can be shared */
+typedef char point_layout_check[(sizeof(Point) == sizeof(gpc_vertex)) ? 1 : -1];
+
 // Added by Francisco Martínez
 void gpc_set_polygon (Polygon& orig, gpc_polygon *p)
 {
@@ -2482,6 +2711,50 @@ void gpc_set_polygon (Polygon& orig, gpc_polygon *p)
 	}
 }
 
+void gpc_view_polygon (Polygon& orig, gpc_polygon *p)
+{
+	p->num_contours = orig.ncontours ();
+	MALLOC(p->hole, p->num_contours * sizeof(int), "hole flag array creation", int);
+	MALLOC(p->contour, p->num_contours * sizeof(gpc_vertex_list), "contour creation", gpc_vertex_list);
+	for (unsigned int i = 0; i < orig.ncontours (); i++) {
+		Contour& c = orig.contour (i);
+		p->contour[i].num_vertices = c.nvertices ();
+		p->hole[i]= FALSE; /* Assume the contours to be external */
+		p->contour[i].vertex = (c.nvertices () > 0) ? reinterpret_cast<gpc_vertex*> (&c.vertex (0)) : NULL;
+	}
+}
+
+void gpc_free_view (gpc_polygon *p)
+{
+	FREE(p->hole);
+	FREE(p->contour);
+	p->num_contours = 0;
+}
+
+void gpc_polygon_clip (gpc_op op, gpc_polygon *subj, gpc_polygon *clip, Polygon& result)
+{
+	node_arena arena;
+	init_arena (&arena);
+	polygon_node* out_poly = polygon_clip (&arena, op, subj, clip);
+	result.clear ();
+	// Create all the contours first, so that filling them never moves a filled one
+	int nc = count_contours (out_poly);
+	for (int c = 0; c < nc; c++)
+		result.pushbackContour ();
+	int c = 0;
+	for (polygon_node* poly = out_poly; poly; poly = poly->next) {
+		if (!poly->active)
+			continue;
+		Contour& contour = result.contour (c++);
+		contour.setExternal (!poly->proxy->hole);
+		contour.resize (poly->active);
+		int v = poly->active - 1;
+		for (vertex_node* vtx = poly->proxy->v[LEFT]; vtx; vtx = vtx->next)
+			contour.vertex (v--) = Point (vtx->x, vtx->y);
+	}
+	release_arena (&arena);
+}
+
 /*
 ===========================================================================
                            End of file: gpc.c
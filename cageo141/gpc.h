@@ -127,6 +127,16 @@ void gpc_free_tristrip       (gpc_tristrip    *tristrip);
 
 void gpc_set_polygon (Polygon& p, gpc_polygon *polygon); // Paco
 
+/* Views of the contours of p, sharing its vertices. Valid while p is not
+   modified; release them with gpc_free_view */
+void gpc_view_polygon (Polygon& p, gpc_polygon *polygon);
+
+void gpc_free_view (gpc_polygon *polygon);
+
+/* Write the result straight into a Polygon, without gpc_vertex arrays */
+void gpc_polygon_clip (gpc_op set_operation, gpc_polygon *subject_polygon,
+                       gpc_polygon *clip_polygon, Polygon& result_polygon);
+
 #endif
 
 /*
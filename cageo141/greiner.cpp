@@ -3,6 +3,7 @@
 #include <iostream>
 #include <list>
 #include <vector>
+#include <algorithm>
 #include <cmath>
 
 #include "utilities.h"
@@ -33,13 +34,12 @@ GreinerContour::GreinerContour (Contour& c): v (c.nvertices ()), nint (0)
 	c.boundingbox (minbox, maxbox);
 }
 
-Vertex *GreinerContour::insert (const Vertex& ver, Vertex *vp)
+Vertex *GreinerContour::insert (Vertex *ver, Vertex *vp)
 {
 	nint++;
-	Vertex *tmp = new Vertex (ver);
-	tmp->next = vp;
-	tmp->prev = vp->prev;
-	return vp->prev = tmp->prev->next = tmp;
+	ver->prev = vp;
+	ver->next = vp->next;
+	return vp->next = ver->next->prev = ver;
 }
 
 void GreinerContour::deleteIntersections ()
@@ -47,29 +47,32 @@ void GreinerContour::deleteIntersections ()
 	if (v.size () == 0 || nint == 0)
 		return;
 	nint = 0;
-	Vertex *v = firstVertex ();
-	do {
-		if (v->intersect) {
-			Vertex* prev = v->prev;
-			do {
-				Vertex* tmp = v;
-				v = v->next;
-				delete tmp;
-			} while (v->intersect);
-			prev->next = v;
-			v->prev = prev;
-		} else
-			v = v->next;
-	} while (v != firstVertex ());
+	for (unsigned int i = 0; i < v.size (); i++) {
+		v[i].next = &v[(i + 1) % v.size ()];
+		v[i].prev = &v[(i + v.size () - 1) % v.size ()];
+	}
 }
 
-bool GreinerContour::intersectBoundingbox (GreinerContour& gc) const
+void GreinerContour::perturb (double eps, unsigned int& seed)
 {
-	if ((minbox.x > gc.maxbox.x || maxbox.x < gc.minbox.x))
-		return false;
-	if ((minbox.y > gc.maxbox.y || maxbox.y < gc.minbox.y))
-		return false;
-	return true;
+	vector<Point> q (v.size ());
+	for (unsigned int i = 0; i < v.size (); i++) {
+		double d[2];
+		for (int k = 0; k < 2; k++) {
+			seed = seed * 1103515245u + 12345u;
+			d[k] = eps * (((seed >> 16) & 0x7fff) / 16383.5 - 1);
+		}
+		q[i] = Point (v[i].x + d[0], v[i].y + d[1]);
+	}
+	for (unsigned int i = 0; i < v.size (); i++)
+		v[i].s = Segment (q[i], q[(i + 1) % v.size ()]);
+	minbox = Point (minbox.x - eps, minbox.y - eps);
+	maxbox = Point (maxbox.x + eps, maxbox.y + eps);
+}
+
+bool GreinerContour::inBoundingbox (const Point& p) const
+{
+	return p.x >= minbox.x && p.x <= maxbox.x && p.y >= minbox.y && p.y <= maxbox.y;
 }
 
 
@@ -83,20 +86,155 @@ ostream& operator<< (ostream& o, GreinerContour& gc)
 	return o;
 }
 
+namespace {
+/** Bounding box of an edge, for the broad phase of the intersection step */
+struct EdgeBox {
+	Vertex* v; // the edge is v->s
+	unsigned int contour; // index of the contour of the edge in its polygon
+	double xmin, xmax, ymin, ymax;
+	EdgeBox (Vertex* ve, unsigned int c) : v (ve), contour (c), xmin (std::min (ve->s.p1.x, ve->s.p2.x)), xmax (std::max (ve->s.p1.x, ve->s.p2.x)),
+	                                       ymin (std::min (ve->s.p1.y, ve->s.p2.y)), ymax (std::max (ve->s.p1.y, ve->s.p2.y)) {}
+	bool operator< (const EdgeBox& e) const { return xmin < e.xmin; }
+};
+}
+
+/** Append the boxes of the original edges of the contours of gp */
+static void addEdges (vector<GreinerContour*>& gp, vector<EdgeBox>& boxes)
+{
+	for (unsigned int i = 0; i < gp.size (); i++) {
+		Vertex *v = gp[i]->firstVertex ();
+		do {
+			if (!v->intersect)
+				boxes.push_back (EdgeBox (v, i));
+			v = v->next;
+		} while (v != gp[i]->firstVertex ());
+	}
+}
+
+/** Remove from the active list the edges that end before x */
+static void expire (vector<EdgeBox*>& active, double x)
+{
+	unsigned n = 0;
+	for (unsigned i = 0; i < active.size (); i++)
+		if (active[i]->xmax >= x)
+			active[n++] = active[i];
+	active.resize (n);
+}
+
+/** Find the pairs (edge of e1, edge of e2) whose bounding boxes overlap. The edges are sorted by xmin and swept from left to
+ *  right; an edge is only tested against the active edges of the other set */
+static void overlappingEdges (vector<EdgeBox>& e1, vector<EdgeBox>& e2, vector<pair<EdgeBox*, EdgeBox*> >& pairs)
+{
+	sort (e1.begin (), e1.end ());
+	sort (e2.begin (), e2.end ());
+	vector<EdgeBox*> active1, active2;
+	unsigned i = 0, j = 0;
+	while (i < e1.size () || j < e2.size ()) {
+		if (j == e2.size () || (i < e1.size () && e1[i].xmin <= e2[j].xmin)) {
+			EdgeBox& e = e1[i++];
+			expire (active2, e.xmin);
+			for (unsigned k = 0; k < active2.size (); k++)
+				if (e.ymin <= active2[k]->ymax && active2[k]->ymin <= e.ymax)
+					pairs.push_back (make_pair (&e, active2[k]));
+			active1.push_back (&e);
+		} else {
+			EdgeBox& e = e2[j++];
+			expire (active1, e.xmin);
+			for (unsigned k = 0; k < active1.size (); k++)
+				if (e.ymin <= active1[k]->ymax && active1[k]->ymin <= e.ymax)
+					pairs.push_back (make_pair (active1[k], &e));
+			active2.push_back (&e);
+		}
+	}
+}
+
+/** Order the intersections by edge, and by alpha along each edge */
+static bool byEdgeAndAlpha (const pair<Vertex*, Vertex*>& a, const pair<Vertex*, Vertex*>& b)
+{
+	return (a.first != b.first) ? a.first < b.first : a.second->alpha < b.second->alpha;
+}
+
+/** Link into gc the intersections found on its edges. Each pair holds the original vertex where the edge begins and the
+ *  intersection vertex */
+static void linkIntersections (GreinerContour& gc, vector<pair<Vertex*, Vertex*> >& ints)
+{
+	sort (ints.begin (), ints.end (), byEdgeAndAlpha);
+	Vertex *last = 0;
+	for (unsigned int i = 0; i < ints.size (); i++) {
+		if (i == 0 || ints[i].first != ints[i-1].first)
+			last = ints[i].first;
+		last = gc.insert (ints[i].second, last);
+	}
+}
+
+/** Intersection of the edges a and b. Return 1 if they cross at a point interior to both, with alphas ta and tb along them,
+ *  0 if they do not meet, and -1 if they meet at an endpoint or overlap, which needs a perturbation */
+static int edgeIntersection (const Segment& a, const Segment& b, Point& p, double& ta, double& tb)
+{
+	double d0x = a.p2.x - a.p1.x, d0y = a.p2.y - a.p1.y;
+	double d1x = b.p2.x - b.p1.x, d1y = b.p2.y - b.p1.y;
+	double ex = b.p1.x - a.p1.x, ey = b.p1.y - a.p1.y;
+	double den = d0x * d1y - d0y * d1x;
+	if (den == 0) {
+		double len0 = d0x * d0x + d0y * d0y;
+		if (len0 == 0 || d1x * d1x + d1y * d1y == 0 || ex * d0y - ey * d0x != 0)
+			return 0; // zero length or parallel edges
+		// the edges lie on the same line
+		double s0 = (ex * d0x + ey * d0y) / len0;
+		double s1 = s0 + (d1x * d0x + d1y * d0y) / len0;
+		return (std::max (s0, s1) < 0 || std::min (s0, s1) > 1) ? 0 : -1;
+	}
+	ta = (ex * d1y - ey * d1x) / den;
+	tb = (ex * d0y - ey * d0x) / den;
+	if (ta < 0 || ta > 1 || tb < 0 || tb > 1)
+		return 0;
+	if (ta == 0 || ta == 1 || tb == 0 || tb == 1)
+		return -1;
+	p = Point (a.p1.x + ta * d0x, a.p1.y + ta * d0y);
+	return 1;
+}
+
+/** Crossing number test of p against the original edges of gp. A fan of triangles from the origin is not used because it
+ *  fails when p lies on one of the lines through the origin and a vertex */
 static bool pointInPolygon (Point& p, GreinerContour& gp)
 {
-	Point origin (0, 0);
-	int inside = 0;
+	bool inside = false;
 	Vertex *v = gp.firstVertex ();
 	do {
-		if (!v->intersect && pointInTriangle (v->s, origin, p))
-			inside ^= 1;
+		if (!v->intersect) {
+			const Point& a = v->s.p1;
+			const Point& b = v->s.p2;
+			if ((a.y > p.y) != (b.y > p.y) && p.x < a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y))
+				inside = !inside;
+		}
 		v = v->next;
 	} while (v != gp.firstVertex ());
 	return inside;
 }
 
-GreinerHormann::GreinerHormann (Polygon& subj, Polygon& cli): gp1 (), gp2 (), subject (subj), clipping (cli)
+/** Even-odd test of p against all the contours of gp. A contour whose bounding box does not hold p adds an even number of
+ *  crossings, so it is skipped */
+static bool pointInPolygon (Point& p, vector<GreinerContour*>& gp)
+{
+	bool inside = false;
+	for (unsigned int i = 0; i < gp.size (); i++)
+		if (gp[i]->inBoundingbox (p) && pointInPolygon (p, *gp[i]))
+			inside = !inside;
+	return inside;
+}
+
+/** Append the vertices of gc to result as a new contour */
+static void addContour (GreinerContour& gc, Polygon& result)
+{
+	Contour& contour = result.pushbackContour ();
+	Vertex *v = gc.firstVertex ();
+	do {
+		contour.add (Point (v->x, v->y));
+		v = v->next;
+	} while (v != gc.firstVertex ());
+}
+
+GreinerHormann::GreinerHormann (Polygon& subj, Polygon& cli): gp1 (), gp2 (), subject (subj), clipping (cli), perturbed (false), seed (1)
 {
 	for (unsigned int i = 0; i < subject.ncontours (); i++)
 		gp1.push_back (new GreinerContour (subject.contour (i)));
@@ -114,14 +252,11 @@ GreinerHormann::~GreinerHormann ()
 
 int GreinerHormann::boolop (Martinez::BoolOpType op, Polygon& result)
 {
-	if ((subject.ncontours () > 0 || clipping.ncontours () > 0) && op != Martinez::INTERSECTION)
-		return -2; // the operation cannot be done
-
 	// Test for trivial result cases
 	if (subject.ncontours () * clipping.ncontours () == 0) { // At least one of the polygons is empty
 		if (op == Martinez::DIFFERENCE)
 			result = subject;
-		if (op == Martinez::UNION)
+		if (op == Martinez::UNION || op == Martinez::XOR)
 			result = (subject.ncontours () == 0) ? clipping : subject;
 		return 0;
 	}
@@ -132,7 +267,7 @@ int GreinerHormann::boolop (Martinez::BoolOpType op, Polygon& result)
 		// the bounding boxes do not overlap
 		if (op == Martinez::DIFFERENCE)
 			result = subject;
-		if (op == Martinez::UNION) {
+		if (op == Martinez::UNION || op == Martinez::XOR) {
 			result = subject;
 			for (unsigned int i = 0; i < clipping.ncontours (); i++) {
 				Contour& c = result.pushbackContour ();
@@ -144,158 +279,193 @@ int GreinerHormann::boolop (Martinez::BoolOpType op, Polygon& result)
 
 	// Boolean operation is not trivial
 
-	int nint = 0;
-	for (unsigned int i = 0; i < gp1.size (); i++) {
-		for (unsigned int j = 0; j < gp2.size (); j++) {
-			gp1[i]->deleteIntersections ();
-			gp2[j]->deleteIntersections ();
-			int ni = boolop (op, *gp1[i], *gp2[j], result);
-			if (ni == -1)
-				return -1;
-			nint += nint;
-		}
+	// step 1. If an intersection falls on a vertex, or two edges overlap, the vertices of the clipping polygon are moved
+	// by a random amount much smaller than the size of the polygons, and the intersections are computed again. The result
+	// keeps the original vertices; only the intersection points are computed on the perturbed edges
+	if (perturbed) {
+		for (unsigned int i = 0; i < gp2.size (); i++)
+			gp2[i]->perturb (0, seed);
+		perturbed = false;
+	}
+	int nint = intersect ();
+	double extent = std::max (std::max (maxsubj.x, maxclip.x) - std::min (minsubj.x, minclip.x),
+	                          std::max (maxsubj.y, maxclip.y) - std::min (minsubj.y, minclip.y));
+	double eps = 1e-10 * extent;
+	for (int k = 0; nint == -1 && k < 4; k++, eps *= 100) {
+		for (unsigned int i = 0; i < gp2.size (); i++)
+			gp2[i]->perturb (eps, seed);
+		perturbed = true;
+		nint = intersect ();
 	}
+	if (nint == -1)
+		return -1;
+
+	// step 2
+	markEntries (gp1, gp2);
+	markEntries (gp2, gp1);
+
+	// step 3
+	if (op == Martinez::XOR) {
+		// subject xor clipping = (subject - clipping) + (clipping - subject)
+		trace (Martinez::DIFFERENCE, gp2, result);
+		for (unsigned int i = 0; i < pool.size (); i++)
+			pool[i].processed = false;
+		trace (Martinez::DIFFERENCE, gp1, result);
+	} else
+		trace (op, gp2, result);
+
+	// The contours with no intersections are wholly inside or outside the other polygon
+	addUncrossed (op, gp1, gp2, true, result);
+	addUncrossed (op, gp2, gp1, false, result);
 	return nint;
 }
 
-int GreinerHormann::boolop (Martinez::BoolOpType op, GreinerContour& gc1, GreinerContour& gc2, Polygon& result)
+int GreinerHormann::intersect ()
 {
-	// step 1
-	if (!gc1.intersectBoundingbox (gc2))
-		return 0;
+	pool.clear ();
+	for (unsigned int i = 0; i < gp1.size (); i++)
+		gp1[i]->deleteIntersections ();
+	for (unsigned int i = 0; i < gp2.size (); i++)
+		gp2[i]->deleteIntersections ();
+
+	// broad phase: only the edges whose bounding boxes overlap reach the exact test
+	vector<EdgeBox> e1, e2;
+	addEdges (gp1, e1);
+	addEdges (gp2, e2);
+	vector<pair<EdgeBox*, EdgeBox*> > candidates;
+	overlappingEdges (e1, e2, candidates);
 
 	int nint = 0; // number of intersections
-	Vertex *v1p = gc1.firstVertex ();
-	do {
-		if (!v1p->intersect) {
-			Vertex *v2p = gc2.firstVertex ();
-			do {
-				if (!v2p->intersect) {
-					Point inter;
-					if (findIntersection (v1p->s, v2p->s, inter, inter) > 0) {
-						if (inter == Point (v1p->x, v1p->y) || inter == Point (v2p->x, v2p->y)) {
-							return -1; // the edge should be peturbed
-						} else {
-							nint++;
-							double distTov1p = (v1p->x - inter.x) * (v1p->x - inter.x) + (v1p->y - inter.y) * (v1p->y - inter.y);
-							double distTov2p = (v2p->x - inter.x) * (v2p->x - inter.x) + (v2p->y - inter.y) * (v2p->y - inter.y);
-							Vertex *x, *y;
-							for (x = v1p->next; x->alpha < distTov1p; x = x->next);
-							for (y = v2p->next; y->alpha < distTov2p; y = y->next);
-							Segment noused;
-							Vertex *v1_address = gc1.insert (Vertex (inter.x, inter.y, noused, true, distTov1p), x);
-							Vertex *v2_address = gc2.insert (Vertex (inter.x, inter.y, noused, true, distTov2p), y);
-							v1_address->neighbor = v2_address;
-							v2_address->neighbor = v1_address;
-						}
-					}
-				}
-				v2p = v2p->next;
-			} while (v2p != gc2.firstVertex ());
-		}
-		v1p = v1p->next;
-	} while (v1p != gc1.firstVertex ());
-
-	if (nint == 0) { // Hay intersección si uno está incluido en el otro
-		Point p (gc1.firstVertex ()->x, gc1.firstVertex ()->y);
-		if (pointInPolygon (p, gc2)) {
-			Contour& contour = result.pushbackContour ();
-			Vertex *v = gc1.firstVertex ();
-			do {
-				contour.add (Point (v->x, v->y));
-				v = v->next;
-			} while (v != gc1.firstVertex ());
-		}
-		p = Point (gc2.firstVertex ()->x, gc2.firstVertex ()->y);
-		if (pointInPolygon (p, gc1)) {
-			Contour& contour = result.pushbackContour ();
-			Vertex *v = gc2.firstVertex ();
-			do {
-				contour.add (Point (v->x, v->y));
-				v = v->next;
-			} while (v != gc2.firstVertex ());
+	// intersections on the edges of every contour of both polygons
+	vector<vector<pair<Vertex*, Vertex*> > > ints1 (gp1.size ()), ints2 (gp2.size ());
+	for (unsigned int k = 0; k < candidates.size (); k++) {
+		Vertex *v1p = candidates[k].first->v;
+		Vertex *v2p = candidates[k].second->v;
+		Point inter;
+		double alpha1, alpha2;
+		int found = edgeIntersection (v1p->s, v2p->s, inter, alpha1, alpha2);
+		if (found == -1) {
+			return -1; // the edge should be peturbed
+		} else if (found == 1) {
+			nint++;
+			Segment noused;
+			pool.push_back (Vertex (inter.x, inter.y, noused, true, alpha1));
+			Vertex *v1_address = &pool.back ();
+			pool.push_back (Vertex (inter.x, inter.y, noused, true, alpha2));
+			Vertex *v2_address = &pool.back ();
+			v1_address->neighbor = v2_address;
+			v2_address->neighbor = v1_address;
+			ints1[candidates[k].first->contour].push_back (make_pair (v1p, v1_address));
+			ints2[candidates[k].second->contour].push_back (make_pair (v2p, v2_address));
 		}
-		return nint;
 	}
-	
-	// step 2
-	Point p (gc1.firstVertex ()->x, gc1.firstVertex ()->y);
-	bool status = ! pointInPolygon (p, gc2);
-	Vertex *v = gc1.firstVertex ();
-	do {
-		if (v->intersect) {
-			v->entry = status;
-			status = !status;
-		}
-		v = v->next;
-	} while (v != gc1.firstVertex ());
+	for (unsigned int i = 0; i < gp1.size (); i++)
+		linkIntersections (*gp1[i], ints1[i]);
+	for (unsigned int i = 0; i < gp2.size (); i++)
+		linkIntersections (*gp2[i], ints2[i]);
+	return nint;
+}
 
-	p = Point (gc2.firstVertex ()->x, gc2.firstVertex ()->y);
-	status = ! pointInPolygon (p, gc1);
-	v = gc2.firstVertex ();
-	do {
-		if (v->intersect) {
-			v->entry = status;
-			status = !status;
-		}
-		v = v->next;
-	} while (v != gc2.firstVertex ());
-	
-	// step 3
-	v = gc2.firstVertex ();
-	do {
-		if (v->intersect && !v->processed) {
-			Contour& contour = result.pushbackContour ();
-			contour.add (Point (v->x, v->y));
-			double x = v->x;
-			double y = v->y;
-			Vertex *current = v;
-			current->processed = true;
-			bool runingPolygon2 = true; // needed for the difference operation
-			do {
-				if (current->entry) {
-					do {
-						switch (op) {
-							case Martinez::INTERSECTION:
-								current = current->next;
-								break;
-							case Martinez::UNION:
-								current = current->prev;
-								break;
-							case Martinez::DIFFERENCE:
-								current = (runingPolygon2) ? current->next : current->prev;
-								break;
-						}
-						contour.add (Point (current->x, current->y));
-					} while (!current->intersect);
-				} else {
-					do {
-						switch (op) {
-							case Martinez::INTERSECTION:
-								current = current->prev;
-								break;
-							case Martinez::UNION:
-								current = current->next;
-								break;
-							case Martinez::DIFFERENCE:
-								current = (runingPolygon2) ? current->prev : current->next;
-								break;
-						}
-						contour.add (Point (current->x, current->y));
-					} while (!current->intersect);
-				}
-				current->processed = true;
-				current = current->neighbor;
+void GreinerHormann::markEntries (vector<GreinerContour*>& gpa, vector<GreinerContour*>& gpb)
+{
+	// Every intersection toggles the even-odd status with respect to gpb, whatever contour of gpb it belongs to
+	for (unsigned int i = 0; i < gpa.size (); i++) {
+		if (!gpa[i]->intersected ())
+			continue;
+		Point p = gpa[i]->firstVertex ()->s.p1; // the vertex may be perturbed
+		bool status = ! pointInPolygon (p, gpb);
+		Vertex *v = gpa[i]->firstVertex ();
+		do {
+			if (v->intersect) {
+				v->entry = status;
+				status = !status;
+			}
+			v = v->next;
+		} while (v != gpa[i]->firstVertex ());
+	}
+}
+
+void GreinerHormann::trace (Martinez::BoolOpType op, vector<GreinerContour*>& gps, Polygon& result)
+{
+	for (unsigned int i = 0; i < gps.size (); i++) {
+		Vertex *v = gps[i]->firstVertex ();
+		do {
+			if (v->intersect && !v->processed) {
+				Contour& contour = result.pushbackContour ();
+				contour.add (Point (v->x, v->y));
+				Vertex *current = v;
 				current->processed = true;
-				runingPolygon2 = !runingPolygon2;
-				
-			} while ((current->x != x) || (current->y != y));
-			// delete the last point, that has been inserted twice
-			Contour::iterator i = contour.end ();
-			i--;
-			contour.erase (i);
+				bool runingPolygon2 = true; // needed for the difference operation
+				do {
+					if (current->entry) {
+						do {
+							switch (op) {
+								case Martinez::INTERSECTION:
+									current = current->next;
+									break;
+								case Martinez::UNION:
+									current = current->prev;
+									break;
+								default: // Martinez::DIFFERENCE
+									current = (runingPolygon2) ? current->next : current->prev;
+									break;
+							}
+							contour.add (Point (current->x, current->y));
+						} while (!current->intersect);
+					} else {
+						do {
+							switch (op) {
+								case Martinez::INTERSECTION:
+									current = current->prev;
+									break;
+								case Martinez::UNION:
+									current = current->next;
+									break;
+								default: // Martinez::DIFFERENCE
+									current = (runingPolygon2) ? current->prev : current->next;
+									break;
+							}
+							contour.add (Point (current->x, current->y));
+						} while (!current->intersect);
+					}
+					current->processed = true;
+					current = current->neighbor;
+					current->processed = true;
+					runingPolygon2 = !runingPolygon2;
+
+				} while (current != v && current != v->neighbor);
+				// delete the last point, that has been inserted twice
+				Contour::iterator it = contour.end ();
+				it--;
+				contour.erase (it);
+			}
+			v = v->next;
+		} while (v != gps[i]->firstVertex ());
+	}
+}
+
+void GreinerHormann::addUncrossed (Martinez::BoolOpType op, vector<GreinerContour*>& gpa, vector<GreinerContour*>& gpb, bool isSubject, Polygon& result)
+{
+	for (unsigned int i = 0; i < gpa.size (); i++) {
+		if (gpa[i]->intersected ())
+			continue;
+		Point p = gpa[i]->firstVertex ()->s.p1; // the vertex may be perturbed
+		bool inside = pointInPolygon (p, gpb);
+		bool add = true; // Martinez::XOR keeps every boundary
+		switch (op) {
+			case Martinez::INTERSECTION:
+				add = inside;
+				break;
+			case Martinez::UNION:
+				add = !inside;
+				break;
+			case Martinez::DIFFERENCE:
+				add = isSubject ? !inside : inside;
+				break;
+			default:
+				break;
 		}
-		v = v->next;
-	} while (v != gc2.firstVertex ());
-	return nint;
+		if (add)
+			addContour (*gpa[i], result);
+	}
 }
@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <vector>
+#include <deque>
 #include <limits>
 #include "segment.h"
 #include "polygon.h"
@@ -28,12 +29,17 @@ ostream& operator<< (ostream& o, const Vertex& v);
 class GreinerContour {
 public:
 	GreinerContour (Contour& c);
-	~GreinerContour () { deleteIntersections (); }
 	Vertex *firstVertex () { return &v[0]; }
-	/** @brief Insert vertex (intersection) v before the vertex pointed by vp */
-	Vertex *insert (const Vertex& v, Vertex *vp);
+	/** @brief Link vertex (intersection) v after the vertex pointed by vp. The vertex is owned by the caller */
+	Vertex *insert (Vertex *v, Vertex *vp);
+	/** @brief Unlink the intersections, restoring the original vertex list */
 	void deleteIntersections ();
-	bool intersectBoundingbox (GreinerContour& gc) const;
+	/** @brief Whether the contour has intersection vertices linked */
+	bool intersected () const { return nint > 0; }
+	bool inBoundingbox (const Point& p) const;
+	/** @brief Move the endpoints of the edges at most eps from the original vertices, which are kept for the result. seed
+	 *  is the state of the random generator */
+	void perturb (double eps, unsigned int& seed);
 private:
 	/** @brief It holds the original vertices of the polygon */
 	vector<Vertex> v;
@@ -55,7 +61,20 @@ private:
 	vector<GreinerContour*> gp2;
 	Polygon& subject;
 	Polygon& clipping;
-	int boolop (Martinez::BoolOpType op, GreinerContour& gc1, GreinerContour& gc2, Polygon& result);
+	/** @brief Intersection vertices of the current run. A deque keeps their addresses stable */
+	deque<Vertex> pool;
+	/** @brief Whether the edges of the clipping polygon are perturbed */
+	bool perturbed;
+	unsigned int seed;
+	/** @brief Step 1: link the intersections between the contours of both polygons. Return their number, or -1 if the
+	 *  polygons should be perturbed */
+	int intersect ();
+	/** @brief Step 2: mark the intersections of the contours of gpa as entry or exit points of gpb */
+	void markEntries (vector<GreinerContour*>& gpa, vector<GreinerContour*>& gpb);
+	/** @brief Step 3: trace the result contours, starting on the contours of gps */
+	void trace (Martinez::BoolOpType op, vector<GreinerContour*>& gps, Polygon& result);
+	/** @brief Add the contours of gpa without intersections that belong to the result */
+	void addUncrossed (Martinez::BoolOpType op, vector<GreinerContour*>& gpa, vector<GreinerContour*>& gpb, bool isSubject, Polygon& result);
 };
 
 #endif
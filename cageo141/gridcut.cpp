@@ -0,0 +1,143 @@
+#include "gridcut.h"
+#include "martinez.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cmath>
+
+class GridCut::TileJob : public Job {
+public:
+	TileJob (GridCut& g, vector<Polygon>& t) : gc (g), tiles (t) {}
+	void run (unsigned t) { gc.cutTile (t % gc.nx, t / gc.nx, tiles[t]); }
+private:
+	GridCut& gc;
+	vector<Polygon>& tiles;
+};
+
+GridCut::GridCut (Polygon& p, const Point& o, double w, double h, unsigned x, unsigned y) :
+	subject (p), origin (o), width (w), height (h), nx (x), ny (y), edges (), crossings (), nclipped (0)
+{
+}
+
+void GridCut::compute (vector<Polygon>& tiles)
+{
+	ThreadPool pool;
+	compute (tiles, pool);
+}
+
+void GridCut::compute (vector<Polygon>& tiles, ThreadPool& pool)
+{
+	route ();
+	tiles.assign (nx * ny, Polygon ());
+	nclipped = 0;
+	for (unsigned t = 0; t < edges.size (); t++)
+		if (!edges[t].empty ())
+			nclipped++;
+	TileJob job (*this, tiles);
+	pool.run (job, nx * ny);
+}
+
+// Range of tiles [first, last] along an axis that can overlap the interval [min, max]. The range is conservative, it is refined with exact tests
+static bool tileRange (double min, double max, double origin, double size, unsigned n, unsigned& first, unsigned& last)
+{
+	double f = floor ((min - origin) / size) - 1;
+	double l = floor ((max - origin) / size) + 1;
+	if (l < 0 || f > n - 1)
+		return false;
+	first = (f < 0) ? 0 : static_cast<unsigned> (f);
+	last = (l > n - 1) ? n - 1 : static_cast<unsigned> (l);
+	return true;
+}
+
+void GridCut::route ()
+{
+	edges.assign (nx * ny, vector<EdgeRef> ());
+	crossings.assign (ny, vector<double> ());
+	for (unsigned c = 0; c < subject.ncontours (); c++) {
+		Contour& contour = subject.contour (c);
+		for (unsigned k = 0; k < contour.nedges (); k++) {
+			Segment s = contour.segment (k);
+			const Point& a = s.begin ();
+			const Point& b = s.end ();
+			double exmin = std::min (a.x, b.x), exmax = std::max (a.x, b.x);
+			double eymin = std::min (a.y, b.y), eymax = std::max (a.y, b.y);
+			unsigned i0, i1, j0, j1;
+			if (!tileRange (eymin, eymax, origin.y, height, ny, j0, j1))
+				continue;
+			bool columns = tileRange (exmin, exmax, origin.x, width, nx, i0, i1);
+			for (unsigned j = j0; j <= j1; j++) {
+				// crossing with the center line of the row (every edge counts, even if it is outside the grid)
+				double yc = ycenter (j);
+				if ((a.y > yc) != (b.y > yc))
+					crossings[j].push_back (a.x + (yc - a.y) * (b.x - a.x) / (b.y - a.y));
+				if (!columns || ymin (j) > eymax || ymax (j) < eymin)
+					continue;
+				for (unsigned i = i0; i <= i1; i++)
+					if (xmin (i) <= exmax && xmax (i) >= exmin)
+						edges[j*nx+i].push_back (EdgeRef (c, k));
+			}
+		}
+	}
+	for (unsigned j = 0; j < ny; j++)
+		sort (crossings[j].begin (), crossings[j].end ());
+}
+
+bool GridCut::inside (unsigned j, double x) const
+{
+	return (lower_bound (crossings[j].begin (), crossings[j].end (), x) - crossings[j].begin ()) % 2;
+}
+
+void GridCut::cutTile (unsigned i, unsigned j, Polygon& result)
+{
+	Polygon tile;
+	Contour& square = tile.pushbackContour ();
+	square.add (Point (xmin (i), ymin (j)));
+	square.add (Point (xmax (i), ymin (j)));
+	square.add (Point (xmax (i), ymax (j)));
+	square.add (Point (xmin (i), ymax (j)));
+
+	if (edges[j*nx+i].empty ()) { // the boundary of the polygon does not reach the tile: the tile is totally inside or outside
+		if (inside (j, (xmin (i) + xmax (i)) / 2))
+			result = tile;
+		return;
+	}
+	if (clipTile (i, j, result))
+		return;
+	// Degenerate case: clip with Martinez's algorithm the contours that reach the tile. The parity of the other contours at the tile
+	// is kept by a rectangle that encloses everything
+	result.clear ();
+	Polygon local;
+	const vector<EdgeRef>& e = edges[j*nx+i];
+	vector<bool> routed (subject.ncontours (), false);
+	for (unsigned k = 0; k < e.size (); k++)
+		routed[e[k].contour] = true;
+	Point min (xmin (i), ymin (j)), max (xmax (i), ymax (j));
+	Point center ((min.x + max.x) / 2, (min.y + max.y) / 2);
+	bool parity = false;
+	for (unsigned c = 0; c < subject.ncontours (); c++) {
+		Contour& contour = subject.contour (c);
+		if (routed[c]) {
+			local.pushbackContour () = contour;
+			Point cmin, cmax;
+			contour.boundingbox (cmin, cmax);
+			min.x = std::min (min.x, cmin.x); min.y = std::min (min.y, cmin.y);
+			max.x = std::max (max.x, cmax.x); max.y = std::max (max.y, cmax.y);
+			continue;
+		}
+		for (unsigned k = 0; k < contour.nedges (); k++) {
+			Segment s = contour.segment (k);
+			const Point& a = s.begin ();
+			const Point& b = s.end ();
+			if ((a.y > center.y) != (b.y > center.y) && a.x + (center.y - a.y) * (b.x - a.x) / (b.y - a.y) < center.x)
+				parity = !parity;
+		}
+	}
+	if (parity) {
+		Contour& frame = local.pushbackContour ();
+		frame.add (Point (min.x - width, min.y - height));
+		frame.add (Point (max.x + width, min.y - height));
+		frame.add (Point (max.x + width, max.y + height));
+		frame.add (Point (min.x - width, max.y + height));
+	}
+	Martinez mr (local, tile);
+	mr.compute (Martinez::INTERSECTION, result);
+}
@@ -0,0 +1,62 @@
+// Cut a polygon by the tiles of a regular grid
+
+#ifndef GRIDCUT_H
+#define GRIDCUT_H
+
+#include "polygon.h"
+#include "point.h"
+#include "rectclip.h"
+#include <vector>
+
+using namespace std;
+
+class ThreadPool;
+
+class GridCut {
+public:
+	/** Class constructor. The grid has nx columns and ny rows of tiles of size width x height, and its bottom-left corner is origin */
+	GridCut (Polygon& p, const Point& origin, double width, double height, unsigned nx, unsigned ny);
+	/** Compute the intersection of the polygon with every tile. tiles[j*nx+i] is the tile in column i and row j */
+	void compute (vector<Polygon>& tiles, ThreadPool& pool);
+	void compute (vector<Polygon>& tiles);
+	/** Number of tiles reached by the boundary of the polygon in the last computation (for statistics) */
+	unsigned nClipped () const { return nclipped; }
+
+private:
+	typedef RectangleClip::EdgeRef EdgeRef;
+	class TileJob;
+
+	Polygon& subject;
+	Point origin;
+	double width;
+	double height;
+	unsigned nx;
+	unsigned ny;
+	/** @brief Edges whose bounding box overlaps every tile */
+	vector<vector<EdgeRef> > edges;
+	/** @brief Sorted x-coordinates of the crossings of the polygon edges with the horizontal line through the center of every row */
+	vector<vector<double> > crossings;
+	unsigned nclipped;
+
+	/** Bounds of the tile in column i and row j */
+	double xmin (unsigned i) const { return origin.x + i * width; }
+	double xmax (unsigned i) const { return origin.x + (i+1) * width; }
+	double ymin (unsigned j) const { return origin.y + j * height; }
+	double ymax (unsigned j) const { return origin.y + (j+1) * height; }
+	double ycenter (unsigned j) const { return (ymin (j) + ymax (j)) / 2; }
+
+	/** Route every edge to the tiles its bounding box overlaps, and compute the crossings with the row center lines */
+	void route ();
+	/** Is the point (x, ycenter (j)) inside the polygon? */
+	bool inside (unsigned j, double x) const;
+	/** Compute the intersection of the polygon with the tile in column i and row j */
+	void cutTile (unsigned i, unsigned j, Polygon& result);
+	/** Compute the intersection of the polygon with the tile (i, j) from the edges routed to the tile. It returns false in degenerate cases
+	 *  (a vertex of the polygon on the boundary of the tile, for example) */
+	bool clipTile (unsigned i, unsigned j, Polygon& result) const
+	{
+		return RectangleClip::clip (subject, edges[j*nx+i], crossings[j], Point (xmin (i), ymin (j)), Point (xmax (i), ymax (j)), result);
+	}
+};
+
+#endif
@@ -7,8 +7,7 @@
 #include "utilities.h"
 #include "martinez.h"
 #include "connector.h"
-#include "greiner.h"
-#include "gpc.h"
+#include "clipper.h"
 #include "timer.h"
 
 #ifndef CALLBACK
@@ -22,10 +21,10 @@ void keyboard (unsigned char key, int x, int y);
 void specialFunc (int key, int x, int y);
 
 Martinez::BoolOpType op = Martinez::INTERSECTION;
-gpc_op opVatti = GPC_INT;
 Polygon* subj;
 Polygon* clip;
 Polygon* result;
+vector<Martinez::Trapezoid> trapezoids; // decomposition of the result computed by Martinez's algorithm
 GLuint displayListSubject, displayListClipping, displayListResult;
 bool showSubject = true;
 bool showClipping = true;
@@ -44,17 +43,17 @@ int main (int argc, char *argv[])
 	glutInit (&argc, argv);
 
 	if (argc < 4) {
-		cerr << "Syntax: " << argv[0] << " subject_pol clipping_pol G|V|M [I|U|D|X]\n";
+		cerr << "Syntax: " << argv[0] << " subject_pol clipping_pol G|V|M|A [I|U|D|X]\n";
 		return 1;
 	}
-	if (argv[3][0] != 'G' && argv[3][0] != 'V' && argv[3][0] != 'M') {
-		cerr << "Syntax: " << argv[0] << " subject_pol clipping_pol G|V|M [I|U|D|X]\n";
-		cerr << "The third parameter set the algorithm. It is a character. It can be G (Greiner), V (Vatti) or M (Martinez)\n";
+	if (argv[3][0] != 'G' && argv[3][0] != 'V' && argv[3][0] != 'M' && argv[3][0] != 'A') {
+		cerr << "Syntax: " << argv[0] << " subject_pol clipping_pol G|V|M|A [I|U|D|X]\n";
+		cerr << "The third parameter set the algorithm. It is a character. It can be G (Greiner), V (Vatti), M (Martinez) or A (Automatic choice)\n";
 		return 2;
 	}
 
 	if (argc > 4 && argv[4][0] != 'I' && argv[4][0] != 'U' && argv[4][0] != 'D' && argv[4][0] != 'X') {
-		cerr << "Syntax: " << argv[0] << " subject_pol clipping_pol G|V|M [I|U|D|X]\n";
+		cerr << "Syntax: " << argv[0] << " subject_pol clipping_pol G|V|M|A [I|U|D|X]\n";
 		cerr << "The last parameter is optional. It is a character. It can be I (Intersection), U (Union), D (Difference) or X (eXclusive or)\n";
 		return 3;
 	}
@@ -62,19 +61,15 @@ int main (int argc, char *argv[])
 		switch (argv[4][0]) {
 			case 'I':
 				op = Martinez::INTERSECTION;
-				opVatti = GPC_INT;
 				break;
 			case 'U':
 				op = Martinez::UNION;
-				opVatti = GPC_UNION;
 				break;
 			case 'D':
 				op = Martinez::DIFFERENCE;
-				opVatti = GPC_DIFF;
 				break;
 			case 'X':
 				op = Martinez::XOR;
-				opVatti = GPC_XOR;
 				break;
 		}
 	}
@@ -89,37 +84,23 @@ int main (int argc, char *argv[])
 	width = (maxi.x - mini.x);
 	height = (maxi.y - mini.y);
 
+	Clipper::Engine engine = Clipper::AUTOMATIC;
 	switch (argv[3][0]) {
-		case 'M': {
-			Martinez mr (*subj, *clip);
-			mr.compute (op, *result);
-			break;}
-		case 'G': {
-			GreinerHormann gh (*subj, *clip);
-			int GreinerResult = gh.boolop (op, *result);
-			if (GreinerResult == -1) {
-				cerr << "Sorry, the Greiner-Hormann's method needs perturbation, and it is not implemented." << endl;
-				return 4;
-			} else if (GreinerResult == -2) {
-				cerr << "Sorry, the Greiner-Hormann's method cannot work with this operation and polygons with more than one region." << endl;
-				return 5;
-			}
-			break; }
+		case 'M':
+			engine = Clipper::MARTINEZ;
+			break;
+		case 'G':
+			engine = Clipper::GREINER;
+			break;
 		case 'V':
-			gpc_polygon subject, clipping, r;
-			gpc_set_polygon (*subj, &subject);
-			gpc_set_polygon (*clip, &clipping);
-			gpc_polygon_clip (opVatti, &subject, &clipping, &r);
-			for (int c = 0; c < r.num_contours; c++) {
-				Contour& contour = result->pushbackContour ();
-				for (int v = 0; v < r.contour[c].num_vertices; v++)
-					contour.add (Point (r.contour[c].vertex[v].x, r.contour[c].vertex[v].y));
-			}
-			gpc_free_polygon (&subject);
-			gpc_free_polygon (&clipping);
-			gpc_free_polygon (&r);
+			engine = Clipper::VATTI;
 			break;
 	}
+	Clipper::Engine used = Clipper::clip (op, *subj, *clip, *result, Clipper::Options (engine, &cerr, 0, false, &trapezoids));
+	if (used != engine && engine != Clipper::AUTOMATIC) {
+		cerr << "Sorry, the Greiner-Hormann's method could not remove the degeneracies of these polygons by perturbation." << endl;
+		return 4;
+	}
 	glutInitDisplayMode (GLUT_DOUBLE | GLUT_RGB);
 	glutInitWindowSize (700, 700);
 	glutInitWindowPosition (100, 100);
@@ -251,6 +232,18 @@ void drawFilledPolygon (GLUtesselator* tObj, Polygon* p)
 	delete[] vert;
 }
 
+void drawTrapezoids (const vector<Martinez::Trapezoid>& t)
+{
+	glBegin (GL_QUADS);
+	for (unsigned i = 0; i < t.size (); i++) {
+		glVertex2d (t[i].x0, t[i].bottom0);
+		glVertex2d (t[i].x1, t[i].bottom1);
+		glVertex2d (t[i].x1, t[i].top1);
+		glVertex2d (t[i].x0, t[i].top0);
+	}
+	glEnd ();
+}
+
 void init ()
 {
 	typedef GLvoid (*parameterlessCallbackType)();
@@ -271,7 +264,10 @@ void init ()
 		drawFilledPolygon (tObj, clip);
 	glEndList ();
 	glNewList (displayListResult, GL_COMPILE);
-		drawFilledPolygon (tObj, result);
+		if (trapezoids.empty ()) // the trapezoids are only computed by Martinez's algorithm, they do not need to be tessellated
+			drawFilledPolygon (tObj, result);
+		else
+			drawTrapezoids (trapezoids);
 	glEndList ();
 
 	glClearColor (1, 1, 1, 1);
@@ -8,11 +8,20 @@
 
 #include "martinez.h"
 #include "connector.h"
+#include "segmentpipe.h"
+#include "raster.h"
+#include "edgeruns.h"
+#include "expression.h"
 #include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <limits>
 #include <cassert>
+#include <cstring>
 #include <signal.h>
 #include <unistd.h>
+#include <sys/time.h>
 
 // #define _DEBUG_ // uncomment this line if you want to debug the computation of the boolean operation
 
@@ -27,7 +36,7 @@ void Martinez::print (SweepEvent& e)
 
 // Compare two sweep events
 // Return true means that e1 is placed at the event queue after e2, i.e,, e1 is processed by the algorithm after e2
-bool Martinez::SweepEventComp::operator() (SweepEvent* e1, SweepEvent* e2) {
+bool Martinez::SweepEventComp::operator() (SweepEvent* e1, SweepEvent* e2) const {
 	if (e1->p.x > e2->p.x) // Different x-coordinate
 		return true;
 	if (e2->p.x > e1->p.x) // Different x-coordinate
@@ -41,30 +50,37 @@ bool Martinez::SweepEventComp::operator() (SweepEvent* e1, SweepEvent* e2) {
 }
 
 // e1 and a2 are the left events of line segments (e1->p, e1->other->p) and (e2->p, e2->other->p)
-bool Martinez::SegmentComp::operator() (SweepEvent* e1, SweepEvent* e2) {
+bool Martinez::SegmentComp::operator() (SweepEvent* e1, SweepEvent* e2) const {
 	if (e1 == e2)
 		return false;
-	if (signedArea (e1->p, e1->other->p, e2->p) != 0 || signedArea (e1->p, e1->other->p, e2->other->p) != 0) {
+	const SegmentRecord& s1 = *e1->seg;
+	const SegmentRecord& s2 = *e2->seg;
+	if (s1.signedArea (s2.l) != 0 || s1.signedArea (s2.r) != 0) {
 		// Segments are not collinear
 		// If they share their left endpoint use the right endpoint to sort
-		if (e1->p == e2->p)
-			return e1->below (e2->other->p);
+		if (s1.l == s2.l)
+			return s1.signedArea (s2.r) > 0;
 		
 		// Different points
 		SweepEventComp comp;
 		if (comp (e1, e2))  // has the line segment associated to e1 been inserted into S after the line segment associated to e2 ?
-			return e2->above (e1->p);
+			return s2.signedArea (s1.l) <= 0;
 		// The line segment associated to e2 has been inserted into S after the line segment associated to e1
-		return e1->below (e2->p);
+		return s1.signedArea (s2.l) > 0;
 	}
 	// Segments are collinear. Just a consistent criterion is used
-	if (e1->p == e2->p)
+	if (s1.l == s2.l)
 		return e1 < e2;
 	SweepEventComp comp;
 	return comp (e1, e2);
 }
 
-void Martinez::compute (BoolOpType op, Polygon& result)
+Martinez::~Martinez ()
+{
+	cancel ();
+}
+
+bool Martinez::trivial (BoolOpType op, Polygon& result, Point& maxsubj, Point& maxclip)
 {
 	// Test 1 for trivial result case
 	if (subject.ncontours () * clipping.ncontours () == 0) { // At least one of the polygons is empty
@@ -72,10 +88,10 @@ void Martinez::compute (BoolOpType op, Polygon& result)
 			result = subject;
 		if (op == UNION)
 			result = (subject.ncontours () == 0) ? clipping : subject;
-		return;
+		return true;
 	}
 	// Test 2 for trivial result case
-	Point minsubj, maxsubj, minclip, maxclip;
+	Point minsubj, minclip;
 	subject.boundingbox (minsubj, maxsubj);
 	clipping.boundingbox (minclip, maxclip);
 	if (minsubj.x > maxclip.x || minclip.x > maxsubj.x || minsubj.y > maxclip.y || minclip.y > maxsubj.y) {
@@ -87,48 +103,464 @@ void Martinez::compute (BoolOpType op, Polygon& result)
 			for (unsigned int i = 0; i < clipping.ncontours (); i++)
 				result.pushbackContour () = clipping.contour (i);
 		}
-		return;
+		return true;
 	}
+	return false;
+}
+
+void Martinez::compute (BoolOpType op, Polygon& result, bool pipelined)
+{
+	Point maxsubj, maxclip;
+	if (trivial (op, result, maxsubj, maxclip))
+		return;
 
 	// Boolean operation is not trivial
+	Connector c; // to connect the edge solutions
+	connector = &c;
+	if (pipelined) {
+		SegmentPipe p (c);
+		pipe = &p;
+		sweep (op, maxsubj, maxclip);
+		p.finish ();
+		pipe = 0;
+	} else
+		sweep (op, maxsubj, maxclip);
+	connector = 0;
+	c.toPolygon (result);
+}
 
-	// Insert all the endpoints associated to the line segments into the event queue
-	for (unsigned int i = 0; i < subject.ncontours (); i++)
-		for (unsigned int j = 0; j < subject.contour (i).nvertices (); j++)
-			processSegment(subject.contour (i).segment (j), SUBJECT);
-	for (unsigned int i = 0; i < clipping.ncontours (); i++)
-		for (unsigned int j = 0; j < clipping.contour (i).nvertices (); j++)
-			processSegment(clipping.contour (i).segment (j), CLIPPING);
-
-	Connector connector; // to connect the edge solutions
-	set<SweepEvent*, SegmentComp> S; // Status line
+void Martinez::clipPolylines (BoolOpType op, Polygon& result)
+{
+	if (op != INTERSECTION)
+		op = DIFFERENCE;
+	Point maxsubj, maxclip;
+	if (trivial (op, result, maxsubj, maxclip))
+		return;
+	pieces.clear ();
+	polylines = true;
+	sweep (op, maxsubj, maxclip);
+	polylines = false;
+	linkPolylines (result);
+}
+
+void Martinez::start (BoolOpType op, Polygon& result)
+{
+	cancel ();
+	Point maxsubj, maxclip;
+	if (trivial (op, result, maxsubj, maxclip))
+		return;
+	stepResult = &result;
+	connector = new Connector;
+	startSweep (op, maxsubj, maxclip);
+}
+
+bool Martinez::resume (unsigned maxEvents, unsigned long micros)
+{
+	if (!stepResult)
+		return true;
+	timeval deadline;
+	if (micros) {
+		gettimeofday (&deadline, 0);
+		deadline.tv_usec += micros % 1000000;
+		deadline.tv_sec += micros / 1000000 + deadline.tv_usec / 1000000;
+		deadline.tv_usec %= 1000000;
+	}
+	if (!advanceSweep (maxEvents, micros ? &deadline : 0))
+		return false;
+	connector->toPolygon (*stepResult);
+	cancel ();
+	return true;
+}
+
+void Martinez::cancel ()
+{
+	if (stepResult) {
+		delete connector;
+		connector = 0;
+		stepResult = 0;
+	}
+	clearSweep ();
+}
+
+void Martinez::clearSweep ()
+{
+	S.clear ();
+	eq = priority_queue<SweepEvent*, vector<SweepEvent*>, SweepEventComp> ();
+	vector<SweepEvent*> ().swap (sorted);
+	nextSorted = 0;
+	eventHolder.clear ();
+	segmentHolder.clear ();
+	chainHolder.clear ();
+	freeEvents.clear ();
+	freeSegments.clear ();
+	bulk = false;
+	flushing = false;
+}
+
+// Read the contours of the polygon file name one by one, adding their edges to runs. max is the maximum corner of the
+// bounding box of the polygon
+static bool readEdges (const string& name, int pl, EdgeRuns& runs, Point& max)
+{
+	ifstream is (name.c_str ());
+	int ncontours;
+	if (!(is >> ncontours))
+		return false;
+	for (int i = 0; i < ncontours; i++) {
+		Contour c;
+		if (!(is >> c))
+			return false;
+		if (c.nvertices () < 3)
+			continue;
+		for (unsigned j = 0; j < c.nvertices (); j++) {
+			const Point& p = c.vertex (j);
+			if (p.x > max.x)
+				max.x = p.x;
+			if (p.y > max.y)
+				max.y = p.y;
+			if (!runs.add (p, c.vertex ((j+1) % c.nvertices ()), pl))
+				return false;
+		}
+	}
+	return true;
+}
+
+bool Martinez::compute (BoolOpType op, const string& subjectFile, const string& clippingFile, const string& resultFile, unsigned runSize)
+{
+	// An empty polygon is below and at the left of everything, so the sweep handles the trivial cases
+	const double lowest = -numeric_limits<double>::max ();
+	Point maxsubj (lowest, lowest), maxclip (lowest, lowest);
+	EdgeRuns runs (runSize);
+	if (!readEdges (subjectFile, SUBJECT, runs, maxsubj) || !readEdges (clippingFile, CLIPPING, runs, maxclip) || !runs.finish ())
+		return false;
+	ofstream os (resultFile.c_str ());
+	if (!os)
+		return false;
+	// The number of contours is only known at the end. Room is left for it at the beginning of the file
+	const int width = 20;
+	os << setw (width) << "" << endl;
+	Polygon subject, clipping;
+	Martinez m (subject, clipping);
+	Connector c (os);
+	m.edges = &runs;
+	m.connector = &c;
+	m.sweep (op, maxsubj, maxclip);
+	os.seekp (0);
+	os << setw (width) << c.size ();
+	return os.good ();
+}
+
+bool Martinez::compute (const Expression& expr, const vector<Polygon*>& operands, Polygon& result)
+{
+	if (expr.noperands () > operands.size () || operands.size () > Expression::MAX_OPERANDS)
+		return false;
+	// The operands are swept instead of the subject and clipping polygons, that are empty
+	Polygon subject, clipping;
+	Martinez m (subject, clipping);
+	Connector c;
+	m.expression = &expr;
+	m.connector = &c;
+	m.sweepOperands (operands);
+	c.toPolygon (result);
+	return true;
+}
+
+void Martinez::overlay (const vector<Polygon*>& operands, vector<Face>& faces)
+{
+	faces.clear ();
+	Polygon subject, clipping;
+	Martinez m (subject, clipping);
+	m.faceRegions = true;
+	m.sweepOperands (operands);
+	for (unsigned label = 1; label < m.sets.size (); label++) {
+		if (!m.faceConnectors[label])
+			continue;
+		faces.push_back (Face ());
+		faces.back ().operands = m.sets[label];
+		faces.back ().area = m.faceAreas[label];
+		m.faceConnectors[label]->toPolygon (faces.back ().region);
+	}
+	m.clearSets ();
+}
+
+void Martinez::overlapAreas (const vector<Polygon*>& operands, unsigned nsubject, vector<Overlap>& overlaps)
+{
+	overlaps.clear ();
+	Polygon subject, clipping;
+	Martinez m (subject, clipping);
+	m.sweepOperands (operands);
+	map<pair<unsigned, unsigned>, double> pairs;
+	for (unsigned label = 1; label < m.sets.size (); label++) {
+		if (m.faceAreas[label] <= 0)
+			continue;
+		const vector<unsigned>& ops = m.sets[label];
+		// the operands of a set are sorted: the ones of the subject layer go first
+		unsigned first = lower_bound (ops.begin (), ops.end (), nsubject) - ops.begin ();
+		for (unsigned i = 0; i < first; i++)
+			for (unsigned j = first; j < ops.size (); j++)
+				pairs[make_pair (ops[i], ops[j] - nsubject)] += m.faceAreas[label];
+	}
+	for (map<pair<unsigned, unsigned>, double>::iterator it = pairs.begin (); it != pairs.end (); it++) {
+		Overlap o = { it->first.first, it->first.second, it->second };
+		overlaps.push_back (o);
+	}
+	m.clearSets ();
+}
+
+void Martinez::sweepOperands (const vector<Polygon*>& ops)
+{
+	operands = &ops;
+	if (!expression) { // the empty set of operands is the label 0
+		clearSets ();
+		sets.push_back (vector<unsigned> ());
+		setIndex[sets.back ()] = 0;
+		faceAreas.push_back (0);
+		faceConnectors.push_back (0);
+	}
+	// Optimization 1 does not apply
+	const double highest = numeric_limits<double>::max ();
+	sweep (XOR, Point (highest, highest), Point (highest, highest));
+	operands = 0;
+}
+
+unsigned Martinez::toggle (unsigned label, unsigned k)
+{
+	if (expression)
+		return label ^ (1u << k);
+	pair<unsigned, unsigned> key (label, k);
+	map<pair<unsigned, unsigned>, unsigned>::iterator it = toggled.find (key);
+	if (it != toggled.end ())
+		return it->second;
+	vector<unsigned> ops = sets[label];
+	vector<unsigned>::iterator pos = lower_bound (ops.begin (), ops.end (), k);
+	if (pos != ops.end () && *pos == k)
+		ops.erase (pos);
+	else
+		ops.insert (pos, k);
+	map<vector<unsigned>, unsigned>::iterator found = setIndex.find (ops);
+	unsigned result;
+	if (found != setIndex.end ()) {
+		result = found->second;
+	} else {
+		result = sets.size ();
+		setIndex[ops] = result;
+		sets.push_back (ops);
+		faceAreas.push_back (0);
+		faceConnectors.push_back (0);
+	}
+	toggled[key] = result;
+	toggled[make_pair (result, k)] = label;
+	return result;
+}
+
+void Martinez::addToFaces (const SweepEvent* l, unsigned below, unsigned above)
+{
+	if (below == above)
+		return;
+	// The area of a region is the integral of y under its upper boundary minus the one under its lower boundary
+	const SegmentRecord& s = *l->seg;
+	double integral = s.dx * (s.l.y + s.r.y) / 2;
+	unsigned side[2] = { below, above };
+	for (int k = 0; k < 2; k++) {
+		if (side[k] == 0)
+			continue;
+		faceAreas[side[k]] += (k == 0) ? integral : -integral;
+		if (faceRegions) {
+			if (!faceConnectors[side[k]])
+				faceConnectors[side[k]] = new Connector;
+			faceConnectors[side[k]]->add (Segment (s.l, s.r));
+		}
+	}
+}
+
+void Martinez::clearSets ()
+{
+	for (unsigned i = 0; i < faceConnectors.size (); i++)
+		delete faceConnectors[i];
+	faceConnectors.clear ();
+	sets.clear ();
+	setIndex.clear ();
+	toggled.clear ();
+	faceAreas.clear ();
+}
+
+void Martinez::compute (BoolOpType op, Raster& raster)
+{
+	// The trivial cases are not special: the sweep rasterizes the edges of the result
+	raster.clear ();
+	if (subject.ncontours () + clipping.ncontours () > 0) {
+		Point minsubj, maxsubj, minclip, maxclip;
+		subject.boundingbox (minsubj, maxsubj);
+		clipping.boundingbox (minclip, maxclip);
+		this->raster = &raster;
+		sweep (op, maxsubj, maxclip);
+		this->raster = 0;
+	}
+	raster.resolve ();
+}
+
+void Martinez::compute (BoolOpType op, vector<Trapezoid>& trapezoids)
+{
+	trapezoids.clear ();
+	if (subject.ncontours () + clipping.ncontours () == 0)
+		return;
+	Point minsubj, maxsubj, minclip, maxclip;
+	subject.boundingbox (minsubj, maxsubj);
+	clipping.boundingbox (minclip, maxclip);
+	this->trapezoids = &trapezoids;
+	sweep (op, maxsubj, maxclip);
+	this->trapezoids = 0;
+}
+
+void Martinez::compute (BoolOpType op, Polygon& result, vector<Trapezoid>& trapezoids)
+{
+	Point maxsubj, maxclip;
+	if (trivial (op, result, maxsubj, maxclip)) {
+		compute (op, trapezoids);
+		return;
+	}
+	trapezoids.clear ();
+	Connector c;
+	connector = &c;
+	this->trapezoids = &trapezoids;
+	sweep (op, maxsubj, maxclip);
+	this->trapezoids = 0;
+	connector = 0;
+	c.toPolygon (result);
+}
+
+// Is the point p placed before the point q in the sweep?
+static bool before (const Point& p, const Point& q)
+{
+	return p.x < q.x || (p.x == q.x && p.y < q.y);
+}
+
+// The y-coordinate at x of the line segment (p, q), where p is its left endpoint
+static double yAt (const Point& p, const Point& q, double x)
+{
+	if (x <= p.x)
+		return p.y;
+	if (x >= q.x)
+		return q.y;
+	return p.y + (x - p.x) * (q.y - p.y) / (q.x - p.x);
+}
+
+void Martinez::addTrapezoid (SweepEvent* below, SweepEvent* above, double x)
+{
+	if (x <= below->trapX)
+		return;
+	Trapezoid t;
+	t.x0 = below->trapX;
+	t.x1 = x;
+	t.bottom0 = yAt (below->seg->l, below->seg->r, t.x0);
+	t.bottom1 = yAt (below->seg->l, below->seg->r, t.x1);
+	t.top0 = yAt (above->seg->l, above->seg->r, t.x0);
+	t.top1 = yAt (above->seg->l, above->seg->r, t.x1);
+	if (t.top0 > t.bottom0 || t.top1 > t.bottom1) // skip the empty trapezoids between overlapping line segments
+		trapezoids->push_back (t);
+}
+
+bool Martinez::inResult (BoolOpType op, bool insideSubject, bool insideClipping)
+{
+	switch (op) {
+		case (INTERSECTION):
+			return insideSubject && insideClipping;
+		case (UNION):
+			return insideSubject || insideClipping;
+		case (DIFFERENCE):
+			return insideSubject && !insideClipping;
+		default:
+			return insideSubject != insideClipping;
+	}
+}
+
+inline void Martinez::addToConnector (const Segment& s)
+{
+	if (pipe)
+		pipe->push (s);
+	else
+		connector->add (s);
+}
+
+void Martinez::sweep (BoolOpType op, const Point& maxsubj, const Point& maxclip)
+{
+	startSweep (op, maxsubj, maxclip);
+	advanceSweep (0, 0);
+}
+
+void Martinez::startSweep (BoolOpType op, const Point& maxsubj, const Point& maxclip)
+{
+	// A previous sweep of the object may have stopped early (optimization 1) or been abandoned: nothing of it is kept
+	clearSweep ();
+	operation = op;
+	// Sort all the endpoints associated to the line segments
+	// (only the first line segment of every monotone chain, the rest are inserted into eq as the sweep advances)
+	bulk = true;
+	for (unsigned int i = 0, e = 0; i < subject.ncontours (); e += subject.contour (i++).nvertices ())
+		processContour (subject.contour (i), SUBJECT, e, 0);
+	for (unsigned int i = 0, e = 0; i < clipping.ncontours (); e += clipping.contour (i++).nvertices ())
+		processContour (clipping.contour (i), CLIPPING, e, 0);
+	for (unsigned int k = 0; operands && k < operands->size (); k++)
+		for (unsigned int i = 0; i < (*operands)[k]->ncontours (); i++)
+			processContour ((*operands)[k]->contour (i), SUBJECT, 0, k);
+	bulk = false;
+	sortEvents ();
+	minMaxX = std::min (maxsubj.x, maxclip.x);
+	maxSubjectX = maxsubj.x;
+	flushing = false;
+}
+
+// Has the time given by deadline passed?
+static bool expired (const timeval& deadline)
+{
+	timeval now;
+	gettimeofday (&now, 0);
+	return now.tv_sec > deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_usec >= deadline.tv_usec);
+}
+
+bool Martinez::advanceSweep (unsigned maxEvents, const timeval* deadline)
+{
+	const BoolOpType op = operation;
 	set<SweepEvent*, SegmentComp>::iterator it, sli, prev, next;
 	SweepEvent* e;
-	const double MINMAXX = std::min (maxsubj.x, maxclip.x); // for optimization 1
+	const double MINMAXX = minMaxX; // for optimization 1
 
-	while (!eq.empty()) {
-		e = eq.top ();
-		eq.pop ();
+	for (unsigned processed = 0; nextEvent () || (edges && !edges->empty ()); processed++) {
+		// the clock is read every 64 events
+		if ((maxEvents && processed == maxEvents) || (deadline && processed % 64 == 0 && processed > 0 && expired (*deadline)))
+			return false;
+		if (flushing) { // optimization 1 for the union: the remaining line segments belong to the result
+			if (nextEvent ()) {
+				e = popEvent ();
+				if (e->chain)
+					processChain (e->chain);
+				if (!e->left)
+					addToConnector (e->segment ());
+			} else {
+				addToConnector (Segment (edges->head ().l, edges->head ().r));
+				edges->pop ();
+			}
+			continue;
+		}
+		// Out of core, the edges of the runs get their events when the sweep reaches their left endpoints
+		while (edges && !edges->empty () && (!nextEvent () || !before (nextEvent ()->p, edges->head ().l))) {
+			processSegment (Segment (edges->head ().l, edges->head ().r), static_cast<PolygonType> (edges->head ().pl));
+			edges->pop ();
+		}
+		e = popEvent ();
+		if (e->chain)
+			processChain (e->chain);
 		#ifdef _DEBUG_
 		cout << "Process event: "; print (*e);
 		#endif
 		// optimization 1
-		if ((op == INTERSECTION && (e->p.x > MINMAXX)) || (op == DIFFERENCE && e->p.x > maxsubj.x)) {
-			connector.toPolygon (result);
-			return;
-		}
-		if ((op == UNION && (e->p.x > MINMAXX))) {
+		if ((op == INTERSECTION && (e->p.x > MINMAXX)) || (op == DIFFERENCE && e->p.x > maxSubjectX))
+			return true;
+		if (op == UNION && e->p.x > MINMAXX && connector && !trapezoids) { // only for contours: the flags of the line segments are not computed
 			// add all the non-processed line segments to the result
 			if (!e->left)
-				connector.add (e->segment ());
-			while (!eq.empty()) {
-				e = eq.top();
-				eq.pop();
-				if (!e->left)
-					connector.add (e->segment ());
-			}
-			connector.toPolygon (result);
-			return;
+				addToConnector (e->segment ());
+			flushing = true;
+			continue;
 		}
 		// end of optimization 1
 
@@ -141,7 +573,7 @@ void Martinez::compute (BoolOpType op, Polygon& result)
 			// Compute the inside and inOut flags
 			if (prev == S.end ()) {           // there is not a previous line segment in S?
 				e->inside = e->inOut = false;
-			} else if ((*prev)->type != NORMAL) {
+			} else if ((*prev)->type != NORMAL && !polylines) {
 				if (prev == S.begin ()) { // e overlaps with prev
 					e->inside = true; // it is not relevant to set true or false
 					e->inOut = false;
@@ -163,6 +595,28 @@ void Martinez::compute (BoolOpType op, Polygon& result)
 				e->inside = ! (*prev)->inOut;
 				e->inOut  = (*prev)->inside;
 			}
+			// A polyline does not bound any region: the region above it is never inside the subject. So the flags of the line
+			// segments above a polyline edge are found as if it were not there (the overlapping ones do not need special flags)
+			if (polylines && e->pl == SUBJECT)
+				e->inOut = true;
+			// The operands of an expression that contain the region above e differ from the ones below it in the operand of e
+			if (operands)
+				e->label = toggle ((prev != S.end ()) ? (*prev)->label : 0, e->seg->operand);
+
+			if (trapezoids) {
+				// The region above prev is now bounded by e
+				next = it;
+				++next;
+				bool subj = e->pl == SUBJECT;
+				e->resultAbove = inResult (op, subj ? !e->inOut : e->inside, subj ? e->inside : !e->inOut);
+				e->trapX = e->p.x;
+				if (prev != S.end () && (*prev)->resultAbove) {
+					if (next != S.end ())
+						addTrapezoid (*prev, *next, e->p.x);
+					(*prev)->trapX = e->p.x;
+				}
+				next = it;
+			}
 
 			#ifdef _DEBUG_
 			cout << "Status line after insertion: " << endl;
@@ -170,13 +624,18 @@ void Martinez::compute (BoolOpType op, Polygon& result)
 				print (**it2);
 			#endif
 
-			// Process a possible intersection between "e" and its next neighbor in S
-			if ((++next) != S.end())
-				possibleIntersection(e, *next);
+			if (operands) {
+				intersectNeighbors (e);
+				fixGroup (e);
+			} else {
+				// Process a possible intersection between "e" and its next neighbor in S
+				if ((++next) != S.end())
+					possibleIntersection(e, *next);
 
-			// Process a possible intersection between "e" and its previous neighbor in S
-			if (prev != S.end ())
-				possibleIntersection(*prev, e);
+				// Process a possible intersection between "e" and its previous neighbor in S
+				if (prev != S.end ())
+					possibleIntersection(*prev, e);
+			}
 		} else { // the line segment must be removed from S
 			next = prev = sli = *(e->other->poss); // S.find (e->other);
 
@@ -185,39 +644,81 @@ void Martinez::compute (BoolOpType op, Polygon& result)
 			(prev != S.begin()) ? --prev : prev = S.end();
 
 			// Check if the line segment belongs to the Boolean operation
-			switch (e->type) {
+			bool contributes = false;
+			bool below = false; // is the region just below the line segment inside the result?
+			bool subj = e->pl == SUBJECT;
+			if (operands) { // the line segments that coincide are decided together, by the first one removed from S
+				if (!e->other->decided)
+					decideGroup (e->other);
+			} else if (polylines) // only the polyline edges belong to the result. The ones that overlap the clipping polygon are inside it
+				contributes = subj && ((e->type == NORMAL) ? e->other->inside == (op == INTERSECTION) : op == INTERSECTION);
+			else switch (e->type) {
 				case (NORMAL):
 					switch (op) {
 						case (INTERSECTION):
-							if (e->other->inside)
-								connector.add (e->segment ());
+							contributes = e->other->inside;
 							break;
 						case (UNION):
-							if (!e->other->inside)
-								connector.add (e->segment ());
+							contributes = !e->other->inside;
 							break;
 						case (DIFFERENCE):
-							if (((e->pl == SUBJECT) && (!e->other->inside)) || (e->pl == CLIPPING && e->other->inside))
-								connector.add (e->segment ());
+							contributes = ((e->pl == SUBJECT) && (!e->other->inside)) || (e->pl == CLIPPING && e->other->inside);
 							break;
 						case (XOR):
-							connector.add (e->segment ());
+							contributes = true;
 							break;
 					}
+					if (raster)
+						below = inResult (op, subj ? e->other->inOut : e->other->inside, subj ? e->other->inside : e->other->inOut);
 					break;
 				case (SAME_TRANSITION):
-					if (op == INTERSECTION || op == UNION)
-						connector.add (e->segment ());
+					contributes = op == INTERSECTION || op == UNION;
+					below = e->other->inOut;
 					break;
 				case (DIFFERENT_TRANSITION):
-					if (op == DIFFERENCE)
-						connector.add (e->segment ());
+					contributes = op == DIFFERENCE;
+					below = subj ? e->other->inOut : !e->other->inOut;
+					break;
+				default:
 					break;
 			}
+			if (trapezoids) {
+				// The regions above e and above prev are closed. The region above prev is now bounded by next
+				if (e->other->resultAbove && next != S.end ())
+					addTrapezoid (e->other, *next, e->p.x);
+				if (prev != S.end () && (*prev)->resultAbove) {
+					addTrapezoid (*prev, e->other, e->p.x);
+					(*prev)->trapX = e->p.x;
+				}
+			}
+			if (contributes) {
+				if (polylines) {
+					PolylinePiece piece = { e->seg->edge, e->seg->l, e->seg->r };
+					pieces.push_back (piece);
+				} else if (connector)
+					addToConnector (e->segment ());
+				else if (raster && below) // the result is at the left of the edge (from the right endpoint to the left endpoint)
+					raster->addEdge (e->p, e->other->p);
+				else if (raster)
+					raster->addEdge (e->other->p, e->p);
+			}
 			// delete line segment associated to e from S and check for intersection between the neighbors of "e" in S
 			S.erase (sli);
-			if (next != S.end() && prev != S.end())
+			if (next != S.end() && prev != S.end() && operands) {
+				if (collinear (*prev, *next))
+					intersectNeighbors (*prev);
+				else
+					possibleIntersection (*prev, *next);
+				fixGroup (*prev);
+			} else if (next != S.end() && prev != S.end())
 				possibleIntersection (*prev, *next);
+			if (edges) { // nothing refers to the line segment any more
+				delete e->other->poss;
+				e->other->poss = 0;
+				freeEvents.push_back (e);
+				freeEvents.push_back (e->other);
+				freeSegments.push_back (e->seg);
+			}
 		}
 
 		#ifdef _DEBUG_
@@ -227,13 +728,134 @@ void Martinez::compute (BoolOpType op, Polygon& result)
 		cout << endl;
 		#endif
 	}
-	connector.toPolygon (result);
+	return true;
+}
+
+// Map a double onto an unsigned key with the same order
+static uint64_t doubleKey (double d)
+{
+	d += 0.0; // -0 and 0 get the same key
+	uint64_t k;
+	memcpy (&k, &d, sizeof (k));
+	return (k & 0x8000000000000000ULL) ? ~k : k | 0x8000000000000000ULL;
+}
+
+void Martinez::sortEvents ()
+{
+	const unsigned n = sorted.size ();
+	vector<EventKey> key (n), tmp (n);
+	for (unsigned i = 0; i < n; i++) {
+		key[i].x = doubleKey (sorted[i]->p.x);
+		key[i].y = doubleKey (sorted[i]->p.y);
+		key[i].left = sorted[i]->left;
+		key[i].e = sorted[i];
+	}
+	// Least significant digit first: the left flag, the bytes of y and the bytes of x. The digits shared by all the keys are skipped
+	for (int d = -1; d < 16 && n > 0; d++) {
+		unsigned count[256];
+		memset (count, 0, sizeof (count));
+		#define DIGIT(k) ((d < 0) ? (k).left : static_cast<unsigned> ((((d < 8) ? (k).y : (k).x) >> (8 * (d % 8))) & 255))
+		for (unsigned i = 0; i < n; i++)
+			count[DIGIT (key[i])]++;
+		if (count[DIGIT (key[0])] == n)
+			continue;
+		for (unsigned c = 0, sum = 0; c < 256; c++) {
+			unsigned t = count[c];
+			count[c] = sum;
+			sum += t;
+		}
+		for (unsigned i = 0; i < n; i++)
+			tmp[count[DIGIT (key[i])]++] = key[i];
+		#undef DIGIT
+		key.swap (tmp);
+	}
+	// The events with the same keys are sorted by the geometric test of SweepEventComp
+	for (unsigned i = 0; i < n; ) {
+		unsigned j = i + 1;
+		while (j < n && key[j].x == key[i].x && key[j].y == key[i].y && key[j].left == key[i].left)
+			j++;
+		if (j - i > 1)
+			sort (key.begin () + i, key.begin () + j, EventBefore ());
+		for (; i < j; i++)
+			sorted[i] = key[i].e;
+	}
+}
+
+Martinez::SweepEvent* Martinez::nextEvent () const
+{
+	SweepEvent* s = (nextSorted < sorted.size ()) ? sorted[nextSorted] : 0;
+	if (eq.empty () || (s && !sec (s, eq.top ())))
+		return s;
+	return eq.top ();
 }
 
-void Martinez::processSegment (const Segment& s, PolygonType pl)
+Martinez::SweepEvent* Martinez::popEvent ()
+{
+	SweepEvent* e = nextEvent ();
+	if (nextSorted < sorted.size () && e == sorted[nextSorted])
+		nextSorted++;
+	else
+		eq.pop ();
+	return e;
+}
+
+void Martinez::processContour (Contour& c, PolygonType pl, unsigned firstEdge, unsigned operand)
+{
+	unsigned n = c.nvertices ();
+	if (n < 2)
+		return;
+	// A polyline has no edge from its last vertex to its first one, so its chains start at its first vertex
+	bool closed = !polylines || pl != SUBJECT;
+	unsigned nedgesContour = closed ? n : n - 1;
+	// Start at an edge whose direction differs from the direction of the previous edge
+	unsigned start = 0;
+	bool dir = before (c.vertex (n-1), c.vertex (0));
+	for (unsigned i = 0; i < n && closed; i++) {
+		bool d = before (c.vertex (i), c.vertex ((i+1) % n));
+		if (d != dir) {
+			start = i;
+			break;
+		}
+		dir = d;
+	}
+	for (unsigned i = 0; i < nedgesContour; ) {
+		unsigned first = (start + i) % n;
+		bool forward = before (c.vertex (first), c.vertex ((first+1) % n));
+		unsigned nedges = 0;
+		do {
+			nedges++;
+			i++;
+		} while (i < nedgesContour && before (c.vertex ((start + i) % n), c.vertex ((start + i + 1) % n)) == forward);
+		Chain chain = { &c, pl, forward ? first : (first + nedges) % n, nedges, forward, firstEdge, operand };
+		chainHolder.push_back (chain);
+		processChain (&chainHolder.back ());
+	}
+}
+
+void Martinez::processChain (Chain* c)
+{
+	unsigned n = c->contour->nvertices ();
+	while (c->nedges > 0) {
+		unsigned next = c->forward ? (c->vertex + 1) % n : (c->vertex + n - 1) % n;
+		SweepEvent* r = processSegment (Segment (c->contour->vertex (c->vertex), c->contour->vertex (next)), c->pl);
+		if (r && polylines)
+			r->seg->edge = c->firstEdge + (c->forward ? c->vertex : next);
+		if (r)
+			r->seg->operand = c->operand;
+		c->vertex = next;
+		c->nedges--;
+		if (r) {
+			if (c->nedges > 0)
+				r->chain = c;
+			return;
+		}
+	}
+}
+
+Martinez::SweepEvent* Martinez::processSegment (const Segment& s, PolygonType pl)
 {
 	if (s.begin () == s.end ()) // if the two edge endpoints are equal the segment is dicarded
-		return;                 // in the future this can be done as preprocessing to avoid "polygons" with less than 3 edges
+		return 0;               // in the future this can be done as preprocessing to avoid "polygons" with less than 3 edges
 	SweepEvent* e1 = storeSweepEvent (SweepEvent(s.begin(), true, pl, 0));
 	SweepEvent* e2 = storeSweepEvent (SweepEvent(s.end(), true, pl, e1));
 	e1->other = e2;
@@ -247,8 +869,41 @@ void Martinez::processSegment (const Segment& s, PolygonType pl)
 	} else {
 		e1->left = false;
 	}
-	eq.push (e1);
-	eq.push (e2);
+	storeSegment (e1, e2);
+	if (bulk) {
+		sorted.push_back (e1);
+		sorted.push_back (e2);
+	} else {
+		eq.push (e1);
+		eq.push (e2);
+	}
+	return e1->left ? e2 : e1;
+}
+
+Martinez::SweepEvent* Martinez::storeSweepEvent (const SweepEvent& e)
+{
+	if (freeEvents.empty ()) {
+		eventHolder.push_back (e);
+		return &eventHolder.back ();
+	}
+	SweepEvent* slot = freeEvents.back ();
+	freeEvents.pop_back ();
+	*slot = e;
+	return slot;
+}
+
+void Martinez::storeSegment (SweepEvent* e1, SweepEvent* e2)
+{
+	if (e2->left)
+		swap (e1, e2);
+	if (freeSegments.empty ()) {
+		segmentHolder.push_back (SegmentRecord (e1->p, e2->p, e1->pl));
+		e1->seg = e2->seg = &segmentHolder.back ();
+	} else {
+		e1->seg = e2->seg = freeSegments.back ();
+		freeSegments.pop_back ();
+		*e1->seg = SegmentRecord (e1->p, e2->p, e1->pl);
+	}
 }
 
 void Martinez::possibleIntersection (SweepEvent* e1, SweepEvent* e2)
@@ -256,30 +911,46 @@ void Martinez::possibleIntersection (SweepEvent* e1, SweepEvent* e2)
 //	if ((e1->pl == e2->pl) ) // you can uncomment these two lines if self-intersecting polygons are not allowed
 //		return false;
 
+	const SegmentRecord& s1 = *e1->seg;
+	const SegmentRecord& s2 = *e2->seg;
+	if (s1.ymax < s2.ymin || s2.ymax < s1.ymin) // the line segments are neighbors in S, so their x-ranges overlap
+		return;
+
 	Point ip1, ip2;  // intersection points
 	int nintersections;
 
-	if (!(nintersections = findIntersection(e1->segment (), e2->segment (), ip1, ip2)))
+	if (!(nintersections = findIntersection(s1.l, s1.r, s1.dx, s1.dy, s2.l, s2.r, s2.dx, s2.dy, ip1, ip2)))
 		return;
 
-	if ((nintersections == 1) && ((e1->p == e2->p) || (e1->other->p == e2->other->p)))
+	if ((nintersections == 1) && ((s1.l == s2.l) || (s1.r == s2.r)))
 		return; // the line segments intersect at an endpoint of both line segments
 
-	if (nintersections == 2 && e1->pl == e2->pl)
-		return; // the line segments overlap, but they belong to the same polygon
+	if (nintersections == 2 && s1.pl == s2.pl && !operands)
+		return; // the line segments overlap, but they belong to the same polygon (the ones of an expression must coincide anyway)
+
+	if (polylines && nintersections == 2 && e1->pl == CLIPPING && e1->p == e2->p) {
+		// The polyline edge e2 is above e1, but it may have been inserted into S first: its flags must take e1 into account
+		e2->inside = !e1->inOut;
+	}
 
 	// The line segments associated to e1 and e2 intersect
 	nint += nintersections;
 
 	if (nintersections == 1) {
 		if (e1->p != ip1 && e1->other->p != ip1)  // if ip1 is not an endpoint of the line segment associated to e1 then divide "e1"
-			divideSegment (e1, ip1);
+			(polylines || operands) ? divideGroup (e1, ip1) : divideSegment (e1, ip1);
 		if (e2->p != ip1 && e2->other->p != ip1)  // if ip1 is not an endpoint of the line segment associated to e2 then divide "e2"
-			divideSegment (e2, ip1);
+			(polylines || operands) ? divideGroup (e2, ip1) : divideSegment (e2, ip1);
 		return;
 	}
 
 	// The line segments overlap
+	if (trapezoids && e1->p == e2->p) {
+		// The region between them is empty, and the flags of e2 do not take e1 into account if e2 was inserted first into S
+		bool subj = e2->pl == SUBJECT;
+		e1->resultAbove = false;
+		e2->resultAbove = inResult (operation, subj ? !e2->inOut : !e1->inOut, subj ? !e1->inOut : !e2->inOut);
+	}
 	vector<SweepEvent *> sortedEvents;
 	if (e1->p == e2->p) {
 		sortedEvents.push_back (0);
@@ -311,21 +982,39 @@ void Martinez::possibleIntersection (SweepEvent* e1, SweepEvent* e2)
 			sortedEvents[0]->other->type = (e1->inOut == e2->inOut) ? SAME_TRANSITION : DIFFERENT_TRANSITION;
 		 else 								// the shared point is the left endpoint
 			sortedEvents[2]->other->type = (e1->inOut == e2->inOut) ? SAME_TRANSITION : DIFFERENT_TRANSITION;
-		divideSegment (sortedEvents[0] ? sortedEvents[0] : sortedEvents[2]->other, sortedEvents[1]->p);
+		operands ? divideGroup (sortedEvents[0] ? sortedEvents[0] : sortedEvents[2]->other, sortedEvents[1]->p)
+		         : divideSegment (sortedEvents[0] ? sortedEvents[0] : sortedEvents[2]->other, sortedEvents[1]->p);
 		return;
 	}
 	if (sortedEvents[0] != sortedEvents[3]->other) { // no line segment includes totally the other one
 		sortedEvents[1]->type = NON_CONTRIBUTING;
 		sortedEvents[2]->type = (e1->inOut == e2->inOut) ? SAME_TRANSITION : DIFFERENT_TRANSITION;
-		divideSegment (sortedEvents[0], sortedEvents[1]->p);
-		divideSegment (sortedEvents[1], sortedEvents[2]->p);
+		operands ? divideGroup (sortedEvents[0], sortedEvents[1]->p) : divideSegment (sortedEvents[0], sortedEvents[1]->p);
+		operands ? divideGroup (sortedEvents[1], sortedEvents[2]->p) : divideSegment (sortedEvents[1], sortedEvents[2]->p);
 		return;
 	}
 	 // one line segment includes the other one
 	sortedEvents[1]->type = sortedEvents[1]->other->type = NON_CONTRIBUTING;
-	divideSegment (sortedEvents[0], sortedEvents[1]->p);
+	operands ? divideGroup (sortedEvents[0], sortedEvents[1]->p) : divideSegment (sortedEvents[0], sortedEvents[1]->p);
 	sortedEvents[3]->other->type = (e1->inOut == e2->inOut) ? SAME_TRANSITION : DIFFERENT_TRANSITION;
-	divideSegment (sortedEvents[3]->other, sortedEvents[2]->p);
+	operands ? divideGroup (sortedEvents[3]->other, sortedEvents[2]->p) : divideSegment (sortedEvents[3]->other, sortedEvents[2]->p);
+}
+
+void Martinez::divideGroup (SweepEvent* e, const Point& p)
+{
+	if (!e->poss) { // e has not been inserted into S yet (it is the right part of a line segment just divided)
+		divideSegment (e, p);
+		return;
+	}
+	set<SweepEvent*, SegmentComp>::iterator first = *e->poss, last = *e->poss, it;
+	while (first != S.begin () && coincident (*(it = first, --it), e))
+		first = it;
+	while (++(it = last) != S.end () && coincident (*it, e))
+		last = it;
+	// The records of the line segments change as they are divided, so they are collected first
+	vector<SweepEvent*> group (first, ++last);
+	for (unsigned i = 0; i < group.size (); i++)
+		divideSegment (group[i], p);
 }
 
 void Martinez::divideSegment (SweepEvent* e, const Point& p)
@@ -345,6 +1034,105 @@ void Martinez::divideSegment (SweepEvent* e, const Point& p)
 	}
 	e->other->other = l;
 	e->other = r;
+	// The record of e is shortened, the right line segment gets a new record
+	SegmentRecord* seg = e->seg;
+	seg->r = p;
+	seg->dx = p.x - seg->l.x;
+	seg->dy = p.y - seg->l.y;
+	seg->ymin = std::min (seg->l.y, p.y);
+	seg->ymax = std::max (seg->l.y, p.y);
+	r->seg = seg;
+	storeSegment (l, l->other);
+	l->seg->edge = seg->edge;
+	l->seg->operand = seg->operand;
 	eq.push(l);
 	eq.push(r);
 }
+
+void Martinez::intersectNeighbors (SweepEvent* e)
+{
+	set<SweepEvent*, SegmentComp>::iterator it = *e->poss;
+	while (++it != S.end ()) {
+		possibleIntersection (e, *it);
+		if (!collinear (e, *it))
+			break;
+	}
+	it = *e->poss;
+	while (it != S.begin ()) {
+		possibleIntersection (*--it, e);
+		if (!collinear (e, *it))
+			break;
+	}
+}
+
+void Martinez::fixGroup (SweepEvent* e)
+{
+	set<SweepEvent*, SegmentComp>::iterator first = *e->poss, it;
+	while (first != S.begin () && coincident (*(it = first, --it), e))
+		first = it;
+	unsigned label = (first != S.begin ()) ? (*(it = first, --it))->label : 0;
+	for (it = first; it != S.end () && coincident (*it, e); ++it)
+		label = (*it)->label = toggle (label, (*it)->seg->operand);
+}
+
+void Martinez::decideGroup (SweepEvent* l)
+{
+	// The line segments below the group may be gone, so the operands below it are found from the label of its bottom member
+	set<SweepEvent*, SegmentComp>::iterator bottom = *l->poss, top = *l->poss, it;
+	while (bottom != S.begin () && coincident (*(it = bottom, --it), l))
+		bottom = it;
+	while (++(it = top) != S.end () && coincident (*it, l))
+		top = it;
+	for (it = bottom; it != top; ++it)
+		(*it)->decided = true;
+	(*top)->decided = true;
+	unsigned below = toggle ((*bottom)->label, (*bottom)->seg->operand);
+	if (!expression)
+		addToFaces (l, below, (*top)->label);
+	else if (expression->evaluate (below) != expression->evaluate ((*top)->label))
+		addToConnector (l->segment ());
+}
+
+/** @brief Orders the pieces of the polylines by edge, and along every edge from its first vertex */
+struct Martinez::PieceOrder {
+	bool operator() (const PolylinePiece& a, const PolylinePiece& b) const
+	{
+		if (a.edge != b.edge)
+			return a.edge < b.edge;
+		return before (a.from, a.to) ? before (a.from, b.from) : before (b.from, a.from);
+	}
+};
+
+void Martinez::linkPolylines (Polygon& result)
+{
+	// The edges of the contour i are numbered from firstEdge[i], as startSweep numbered them
+	vector<unsigned> firstEdge (1, 0);
+	for (unsigned int i = 0; i < subject.ncontours (); i++)
+		firstEdge.push_back (firstEdge.back () + subject.contour (i).nvertices ());
+	for (unsigned int k = 0; k < pieces.size (); k++) {
+		unsigned c = upper_bound (firstEdge.begin (), firstEdge.end (), pieces[k].edge) - firstEdge.begin () - 1;
+		unsigned v = pieces[k].edge - firstEdge[c];
+		if (before (subject.contour (c).vertex (v + 1), subject.contour (c).vertex (v)))
+			swap (pieces[k].from, pieces[k].to);
+	}
+	sort (pieces.begin (), pieces.end (), PieceOrder ());
+	// A piece continues the chain of the previous one if it starts where that one ends, on the same polyline. If they are
+	// parts of different edges, the previous one must reach the end of its edge, and the edges between both must have no
+	// length (they are not added to the sweep)
+	Contour* chain = 0;
+	for (unsigned int k = 0; k < pieces.size (); k++) {
+		unsigned c = upper_bound (firstEdge.begin (), firstEdge.end (), pieces[k].edge) - firstEdge.begin () - 1;
+		Contour& polyline = subject.contour (c);
+		bool joined = k > 0 && pieces[k-1].edge >= firstEdge[c] && pieces[k].from == pieces[k-1].to;
+		if (joined && pieces[k-1].edge != pieces[k].edge)
+			joined = pieces[k-1].to == polyline.vertex (pieces[k-1].edge - firstEdge[c] + 1);
+		for (unsigned e = joined ? pieces[k-1].edge + 1 : 0; joined && e < pieces[k].edge; e++)
+			joined = polyline.vertex (e - firstEdge[c]) == polyline.vertex (e - firstEdge[c] + 1);
+		if (!joined) {
+			chain = &result.pushbackContour ();
+			chain->add (pieces[k].from);
+		}
+		chain->add (pieces[k].to);
+	}
+	pieces.clear ();
+}
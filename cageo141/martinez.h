@@ -17,18 +17,96 @@
 #include <queue>
 #include <vector>
 #include <set>
+#include <map>
+#include <string>
+#include <stdint.h>
+#include <sys/time.h>
 
 using namespace std;
 
 class Connector;
+class Raster;
+class EdgeRuns;
+class SegmentPipe;
+class Expression;
 
 class Martinez {
 public:
 	enum BoolOpType { INTERSECTION, UNION, DIFFERENCE, XOR };
+	/** @brief Trapezoid with vertical parallel sides at x0 and x1. Its bottom side joins (x0, bottom0) and (x1, bottom1), and its top side
+	 *  joins (x0, top0) and (x1, top1) */
+	struct Trapezoid {
+		double x0, x1;
+		double bottom0, bottom1;
+		double top0, top1;
+	};
+	/** @brief Region of the overlay of several polygons covered by the same operands */
+	struct Face {
+		vector<unsigned> operands; // operands that cover the region, in increasing order
+		Polygon region;
+		double area;
+	};
+	/** @brief Area covered by both an operand of the subject layer and an operand of the clipping layer of an overlay */
+	struct Overlap {
+		unsigned subject;  // operand of the subject layer
+		unsigned clipping; // operand of the clipping layer, counted from the first one of that layer
+		double area;
+	};
 	/** Class constructor */
-	Martinez (Polygon& sp, Polygon& cp) : eq (), eventHolder (), subject (sp), clipping (cp), sec (), nint (0) {}
-	/** Compute the boolean operation */
-	void compute (BoolOpType op, Polygon& result);
+	Martinez (Polygon& sp, Polygon& cp) : eq (), eventHolder (), chainHolder (), segmentHolder (), subject (sp), clipping (cp), sec (), nint (0), operation (INTERSECTION), connector (0), pipe (0), raster (0), trapezoids (0), edges (0),
+		freeEvents (), freeSegments (), bulk (false), sorted (), nextSorted (0), S (), minMaxX (0), maxSubjectX (0), flushing (false), stepResult (0),
+		polylines (false), pieces (), operands (0), expression (0), sets (), setIndex (), toggled (), faceAreas (), faceConnectors (), faceRegions (false) {}
+	/** Class destructor */
+	~Martinez ();
+	/** Compute the boolean operation. If pipelined is set, the edges of the result are linked into contours by a second
+	 *  thread while the sweep goes on. The two stages can only overlap on two or more processors, and whether that is faster
+	 *  than the serial linking has not been measured */
+	void compute (BoolOpType op, Polygon& result, bool pipelined = false);
+	/** Compute the boolean operation, writing the coverage of the result into a raster instead of building its contours */
+	void compute (BoolOpType op, Raster& raster);
+	/** Compute the boolean operation as a set of disjoint trapezoids that cover the result. They are found by the sweep itself */
+	void compute (BoolOpType op, vector<Trapezoid>& trapezoids);
+	/** Compute the boolean operation, and the trapezoids that cover its result, in the same sweep */
+	void compute (BoolOpType op, Polygon& result, vector<Trapezoid>& trapezoids);
+	/** Clip the contours of the subject, taken as open polylines (the edge from the last vertex to the first one is not part of
+	 *  them), with the clipping polygon. result gets the parts of the polylines inside the clipping polygon for INTERSECTION,
+	 *  and the parts outside of it for the other operations, as open chains. Every chain is a part of a single polyline, with
+	 *  its vertices in the order of the polyline, even where polylines cross or touch each other. The parts on the boundary of
+	 *  the clipping polygon are inside it. The polylines do not bound any region, so only their own edges are added to the
+	 *  sweep */
+	void clipPolylines (BoolOpType op, Polygon& result);
+	/** Compute the boolean operation between the polygons of the files subjectFile and clippingFile, writing the result to
+	 *  resultFile, out of core. The edges are sorted into temporary files, in runs of runSize edges, that are merged as the sweep
+	 *  advances; the events of the processed line segments are reused, and the contours of the result are written as soon as
+	 *  they are closed. So the memory used depends on the number of line segments that cross the sweep line, not on the
+	 *  size of the polygons. It returns false if a file cannot be read or written */
+	static bool compute (BoolOpType op, const string& subjectFile, const string& clippingFile, const string& resultFile,
+	                     unsigned runSize = 1 << 20);
+	/** Compute the boolean expression expr over the polygons operands (operands[k] is the operand k of expr) with one sweep,
+	 *  without intermediate results. Every line segment keeps the mask of the operands that contain the region just above it,
+	 *  and it belongs to the result if expr takes different values at both sides of it. The line segments that overlap are
+	 *  split so that they coincide, whatever their operands, and they are decided together. It returns false if expr refers to
+	 *  operands not given, or if there are more than Expression::MAX_OPERANDS operands */
+	static bool compute (const Expression& expr, const vector<Polygon*>& operands, Polygon& result);
+	/** Compute the planar overlay of the polygons operands with one sweep: every region covered by a different set of
+	 *  operands is a face, whatever the number of operands. The line segments carry the index of the set of operands above
+	 *  them instead of a mask, and a decided line segment is a boundary of the faces of the sets below and above it. The
+	 *  region not covered by any operand is not a face */
+	static void overlay (const vector<Polygon*>& operands, vector<Face>& faces);
+	/** Compute the area of the intersection of every operand of the subject layer (the operands 0 to nsubject-1) with every
+	 *  operand of the clipping layer (the rest of the operands) with the sweep of overlay, without building the faces. Only
+	 *  the pairs that overlap are given, sorted */
+	static void overlapAreas (const vector<Polygon*>& operands, unsigned nsubject, vector<Overlap>& overlaps);
+	/** Start computing the boolean operation step by step, so that the computation can be interleaved with other work or
+	 *  abandoned: the events of the sweep are processed by the calls to resume. The trivial cases are solved at once */
+	void start (BoolOpType op, Polygon& result);
+	/** Continue the computation begun by start, processing at most maxEvents events and stopping once micros microseconds have
+	 *  elapsed (0 means no limit). It returns true when the computation is finished: result holds the boolean operation */
+	bool resume (unsigned maxEvents, unsigned long micros = 0);
+	/** Abandon the computation begun by start, if any, releasing the memory of the sweep. result is not modified */
+	void cancel ();
+	/** Has a computation begun by start not finished yet? */
+	bool pending () const { return stepResult != 0; }
 	/** Number of intersections found (for statistics) */
 	int nInt () const { return nint; }
 
@@ -36,6 +114,35 @@ private:
 	enum EdgeType { NORMAL, NON_CONTRIBUTING, SAME_TRANSITION, DIFFERENT_TRANSITION };
 	enum PolygonType { SUBJECT, CLIPPING };
 
+	/** @brief Monotone chain of edges of a contour: its vertices are sorted as the events of the sweep (by x, and then by y).
+	 *  The events of an edge of the chain are only created when the previous edge of the chain ends */
+	struct Chain {
+		Contour* contour;
+		PolygonType pl;
+		unsigned vertex; // first vertex of the next edge of the chain
+		unsigned nedges; // number of edges of the chain still not processed
+		bool forward;    // are the vertices of the chain in the order of the contour?
+		unsigned firstEdge; // index of the first edge of the contour among the edges of its polygon (only for polylines)
+		unsigned operand;   // operand the contour belongs to (only for expressions and overlays)
+	};
+
+	/** @brief Line segment of the sweep, shared by its two events. The comparisons and the intersection tests read it instead of
+	 *  following the pointers to the other events */
+	struct SegmentRecord {
+		Point l, r;         // left and right endpoints
+		double dx, dy;      // r - l
+		double ymin, ymax;  // range of y-coordinates
+		PolygonType pl;     // Polygon to which the line segment belongs to
+		unsigned edge;      // Only used for polylines. Edge of the subject the line segment is part of
+		unsigned operand;   // Only used for expressions and overlays. Operand the line segment belongs to
+
+		SegmentRecord (const Point& al, const Point& ar, PolygonType apl) :
+			l (al), r (ar), dx (ar.x - al.x), dy (ar.y - al.y), ymin (std::min (al.y, ar.y)), ymax (std::max (al.y, ar.y)), pl (apl), edge (0),
+			operand (0) {}
+		/** Twice the signed area of the triangle (l, r, x). It is positive if the line segment is below x */
+		double signedArea (const Point& x) const { return (l.x - x.x) * dy - dx * (l.y - x.y); }
+	};
+
 	struct SweepEvent {
 		Point p;           // point associated with the event
 		bool left;         // is the point the left endpoint of the segment (p, other->p)?
@@ -46,15 +153,22 @@ private:
 		EdgeType type;
 		bool inside; // Only used in "left" events. Is the segment (p, other->p) inside the other polygon?
 		set<SweepEvent*>::iterator* poss; // Only used in "left" events. Position of the event (line segment) in S
+		bool resultAbove; // Only used in "left" events when computing trapezoids. Is the region just above the line segment inside the result?
+		double trapX;     // Only used in "left" events when computing trapezoids. x-coordinate where the current trapezoid above the line segment starts
+		unsigned label;   // Only used in "left" events when computing an expression or an overlay. Operands that contain the region just above the line segment: a mask for an expression, or the index of their set for an overlay
+		bool decided;     // Only used in "left" events when computing an expression or an overlay. Has the line segment been decided with a coincident one?
+		Chain* chain;     // Chain whose next edge starts at this event (if any)
+		SegmentRecord* seg; // Line segment (p, other->p)
 
 		/** Class constructor */
-		SweepEvent (const Point& pp, bool b, PolygonType apl, SweepEvent* o, EdgeType t = NORMAL) : p (pp), left (b), pl (apl), other (o), type (t), poss (0) {}
+		SweepEvent (const Point& pp, bool b, PolygonType apl, SweepEvent* o, EdgeType t = NORMAL) : p (pp), left (b), pl (apl), other (o), type (t), poss (0), label (0), decided (false),
+			chain (0), seg (0) {}
 		/** Class destructor */
 		~SweepEvent () { delete poss; }
  		/** Return the line segment associated to the SweepEvent */
 		Segment segment () { return Segment (p, other->p); }
 		/** Is the line segment (p, other->p) below point x */
-		bool below (const Point& x) const { return (left) ? signedArea (p, other->p, x) > 0 : signedArea (other->p, p, x) > 0; }
+		bool below (const Point& x) const { return seg->signedArea (x) > 0; }
 		/** Is the line segment (p, other->p) above point x */
 		bool above (const Point& x) const { return !below (x); }
 	};
@@ -62,17 +176,33 @@ private:
 	static void print (SweepEvent& e); // This function is intended for debugging purposes
 
 	struct SweepEventComp : public binary_function<SweepEvent*, SweepEvent*, bool> {
-		bool operator() (SweepEvent* e1, SweepEvent* e2);
+		bool operator() (SweepEvent* e1, SweepEvent* e2) const;
 	};
 
 	struct SegmentComp : public binary_function<SweepEvent*, SweepEvent*, bool> {
-		bool operator() (SweepEvent* e1, SweepEvent* e2);
+		bool operator() (SweepEvent* e1, SweepEvent* e2) const;
+	};
+
+	/** @brief Integer keys of an event with the order of SweepEventComp, except for the final geometric test: the keys of the
+	 *  coordinates compare as the coordinates, and right events (left == 0) go first */
+	struct EventKey {
+		uint64_t x, y;
+		unsigned left;
+		SweepEvent* e;
+	};
+	/** @brief Is e1 processed before e2? */
+	struct EventBefore {
+		bool operator() (const EventKey& e1, const EventKey& e2) const { return SweepEventComp () (e2.e, e1.e); }
 	};
 	
 	/** @brief Event Queue */
 	priority_queue<SweepEvent*, vector<SweepEvent*>, SweepEventComp> eq;
 	/** @brief It holds the events generated during the computation of the boolean operation */
 	deque<SweepEvent> eventHolder;
+	/** @brief It holds the monotone chains of the polygons */
+	deque<Chain> chainHolder;
+	/** @brief It holds the line segments of the events */
+	deque<SegmentRecord> segmentHolder;
 	/** @brief Polygon 1 */
 	Polygon& subject;
 	/** @brief Polygon 2 */
@@ -81,14 +211,127 @@ private:
 	SweepEventComp sec;
 	/** @brief Number of intersections (for statistics) */
 	int nint;
-	/** @brief Compute the events associated to segment s, and insert them into pq and eq */
-	void processSegment (const Segment& s, PolygonType pl);
+	/** @brief Boolean operation being computed */
+	BoolOpType operation;
+	/** @brief Output of the sweep: only one of them is not null */
+	Connector* connector;
+	/** @brief If it is not null, the edges of the result are sent through it to connector, that is used by another thread */
+	SegmentPipe* pipe;
+	Raster* raster;
+	vector<Trapezoid>* trapezoids;
+	/** @brief Edges sorted in runs, that are inserted into eq as the sweep reaches them (only out of core) */
+	EdgeRuns* edges;
+	/** @brief Slots of eventHolder and segmentHolder of the line segments already processed (only out of core) */
+	vector<SweepEvent*> freeEvents;
+	vector<SegmentRecord*> freeSegments;
+	/** @brief While it is set, the events created are stored in sorted instead of eq */
+	bool bulk;
+	/** @brief Events of the first edges of the chains, sorted by sortEvents. They are merged with eq as the sweep advances */
+	vector<SweepEvent*> sorted;
+	unsigned nextSorted;
+	/** @brief Status line */
+	set<SweepEvent*, SegmentComp> S;
+	/** @brief Optimization 1: the sweep may stop beyond the least of the maximum x-coordinates of the polygons, or beyond the
+	 *  maximum x-coordinate of the subject */
+	double minMaxX, maxSubjectX;
+	/** @brief Is the sweep adding the remaining line segments to the result without processing them (optimization 1 for the union)? */
+	bool flushing;
+	/** @brief Result of the computation begun by start (0 if there is none). Its connector is owned by the object */
+	Polygon* stepResult;
+	/** @brief Are the contours of the subject open polylines? */
+	bool polylines;
+	/** @brief Part of an edge of a polyline in the result, from its endpoint nearer to the start of the polyline */
+	struct PolylinePiece {
+		unsigned edge;
+		Point from, to;
+	};
+	/** @brief Output of the sweep for polylines */
+	vector<PolylinePiece> pieces;
+	struct PieceOrder;
+	/** @brief Operands swept instead of the subject and the clipping polygons (only for expressions and overlays), and
+	 *  expression computed over them (null for an overlay) */
+	const vector<Polygon*>* operands;
+	const Expression* expression;
+	/** @brief Sets of operands found by the overlay, the index of every set, and the set found by adding or removing an operand
+	 *  of a set (the key is the index of the set and the operand) */
+	vector<vector<unsigned> > sets;
+	map<vector<unsigned>, unsigned> setIndex;
+	map<pair<unsigned, unsigned>, unsigned> toggled;
+	/** @brief Area of the face of every set, and connector of its boundary. Are the boundaries of the faces wanted, or only
+	 *  their areas? */
+	vector<double> faceAreas;
+	vector<Connector*> faceConnectors;
+	bool faceRegions;
+	/** @brief Solve the trivial cases: an empty polygon, or bounding boxes that do not overlap. It returns false if the
+	 *  boolean operation is not trivial; then maxsubj and maxclip are the maximum corners of the bounding boxes */
+	bool trivial (BoolOpType op, Polygon& result, Point& maxsubj, Point& maxclip);
+	/** @brief Run the sweep of the boolean operation, sending the result to the output that is not null */
+	void sweep (BoolOpType op, const Point& maxsubj, const Point& maxclip);
+	/** @brief Release the memory of the sweep, leaving it empty: the events, line segments and chains, the event queue and the
+	 *  status line */
+	void clearSweep ();
+	/** @brief Sort the events of the polygons into an empty sweep, ready for advanceSweep */
+	void startSweep (BoolOpType op, const Point& maxsubj, const Point& maxclip);
+	/** @brief Process at most maxEvents events of the sweep (0: no limit), stopping at deadline if it is not null. It returns true
+	 *  when the sweep is over */
+	bool advanceSweep (unsigned maxEvents, const timeval* deadline);
+	/** @brief Sort the events stored in sorted with a radix sort of their keys. Only the events with the same keys are compared
+	 *  geometrically */
+	void sortEvents ();
+	/** @brief The next event of the sweep, the first one of eq and sorted (0 if there is none) */
+	SweepEvent* nextEvent () const;
+	/** @brief Remove the next event of the sweep, and return it */
+	SweepEvent* popEvent ();
+	/** @brief Send the edge s of the result to connector */
+	void addToConnector (const Segment& s);
+	/** @brief Output the trapezoid of the region between the line segments associated to the left events below and above, from below->trapX to x */
+	void addTrapezoid (SweepEvent* below, SweepEvent* above, double x);
+	/** @brief Is a point inside the result, given whether it is inside the subject and inside the clipping polygons? */
+	static bool inResult (BoolOpType op, bool insideSubject, bool insideClipping);
+	/** @brief Compute the events associated to segment s, and insert them into eq. It returns the right event (0 for a degenerate segment) */
+	SweepEvent* processSegment (const Segment& s, PolygonType pl);
+	/** @brief Split contour c into monotone chains, and insert the events of the first edge of every chain into eq. firstEdge
+	 *  is the index of the first edge of c among the edges of its polygon, and operand the operand of an expression c belongs
+	 *  to */
+	void processContour (Contour& c, PolygonType pl, unsigned firstEdge, unsigned operand);
+	/** @brief Insert the events of the next edge of chain c into eq */
+	void processChain (Chain* c);
 	/** @brief Process a posible intersection between the segment associated to the left events e1 and e2 */
 	void possibleIntersection (SweepEvent *e1, SweepEvent *e2);
+	/** @brief Divide the line segment of the left event e at p, and the line segments of S that coincide with it, so that they
+	 *  still coincide. A polyline may follow the boundary of the clipping polygon and be crossed there, and p is rounded. If e is
+	 *  not in S, only its line segment is divided */
+	void divideGroup (SweepEvent* e, const Point& p);
 	/** @brief Divide the segment associated to left event e, updating pq and (implicitly) the status line */
 	void divideSegment (SweepEvent *e, const Point& p);
+	/** @brief Do the line segments of the left events e1 and e2 have the same endpoints? */
+	static bool coincident (const SweepEvent* e1, const SweepEvent* e2) { return e1->seg->l == e2->seg->l && e1->seg->r == e2->seg->r; }
+	/** @brief Are the line segments of the left events e1 and e2 collinear? */
+	static bool collinear (const SweepEvent* e1, const SweepEvent* e2) { return e1->seg->signedArea (e2->seg->l) == 0 && e1->seg->signedArea (e2->seg->r) == 0; }
+	/** @brief Sweep the operands of an expression or an overlay. The sweep goes beyond every operand */
+	void sweepOperands (const vector<Polygon*>& ops);
+	/** @brief Label of the region found by crossing a line segment of operand k from the region with the given label */
+	unsigned toggle (unsigned label, unsigned k);
+	/** @brief Output the line segment of the left event l to the faces of the overlay, given the labels below and above it */
+	void addToFaces (const SweepEvent* l, unsigned below, unsigned above);
+	/** @brief Release the sets of operands of the overlay */
+	void clearSets ();
+	/** @brief Process the possible intersections of the line segment of the left event e with its neighbors in S. More than two
+	 *  line segments of an expression may overlap: e is compared with all the collinear line segments next to it */
+	void intersectNeighbors (SweepEvent* e);
+	/** @brief Recompute the labels of the line segments of S that coincide with the one of the left event e, from the label of
+	 *  the line segment below them: the labels found when they were inserted may not take into account the ones inserted later */
+	void fixGroup (SweepEvent* e);
+	/** @brief Decide the line segment of the left event l, and the ones that coincide with it, from the operands below and above
+	 *  all of them: they belong to the result if the expression differs at both sides, or they bound the faces of the sets of
+	 *  both sides */
+	void decideGroup (SweepEvent* l);
+	/** @brief Join the consecutive pieces of every polyline into the chains of result */
+	void linkPolylines (Polygon& result);
 	/** @brief Store the SweepEvent e into the event holder, returning the address of e */
-	SweepEvent *storeSweepEvent(const SweepEvent& e) { eventHolder.push_back (e); return &eventHolder.back (); }
+	SweepEvent *storeSweepEvent(const SweepEvent& e);
+	/** @brief Store the line segment joining the events e1 and e2, and link the events to it */
+	void storeSegment (SweepEvent* e1, SweepEvent* e2);
 };
 
 #endif
@@ -0,0 +1,203 @@
+#include "polygon.h"
+#include "martinez.h"
+#include "expression.h"
+#include "timer.h"
+#include <fstream>
+#include <deque>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+using namespace std;
+
+// Sum of the areas of the contours of p
+static double contoursArea (Polygon& p)
+{
+	double area = 0;
+	for (unsigned int i = 0; i < p.ncontours (); i++) {
+		Contour& c = p.contour (i);
+		double a = 0;
+		for (unsigned int j = 0; j < c.nvertices (); j++) {
+			const Point& u = c.vertex (j);
+			const Point& v = c.vertex ((j + 1) % c.nvertices ());
+			a += u.x * v.y - v.x * u.y;
+		}
+		area += fabs (a) / 2;
+	}
+	return area;
+}
+
+// Area of p, with its holes subtracted
+static double area (Polygon& p)
+{
+	p.computeHoles ();
+	double area = 0;
+	for (unsigned int i = 0; i < p.ncontours (); i++) {
+		Polygon single;
+		single.pushbackContour () = p.contour (i);
+		area += p.contour (i).external () ? contoursArea (single) : -contoursArea (single);
+	}
+	return area;
+}
+
+static bool differ (double a, double b)
+{
+	return fabs (a - b) > 1e-9 * std::max (fabs (a), fabs (b));
+}
+
+// Compute the overlay of the operands, and the areas of the overlaps of the subject layer (the first nsubject operands) with
+// the clipping layer. Both must agree with the intersections of every pair of operands by Martínez-Rueda's algorithm
+static int overlay (unsigned nsubject, const char* resultName, const vector<Polygon*>& operands)
+{
+	Timer timer;
+	vector<Martinez::Face> faces;
+	timer.start ();
+	Martinez::overlay (operands, faces);
+	timer.stop ();
+	cout << "Overlay time (" << faces.size () << " faces): " << timer.timeSecs () << endl;
+	vector<Martinez::Overlap> overlaps;
+	timer.start ();
+	Martinez::overlapAreas (operands, nsubject, overlaps);
+	timer.stop ();
+	cout << "Overlap areas time (" << overlaps.size () << " overlaps): " << timer.timeSecs () << endl;
+	vector<double> pairArea (nsubject * (operands.size () - nsubject));
+	timer.start ();
+	for (unsigned i = 0; i < nsubject; i++)
+		for (unsigned j = nsubject; j < operands.size (); j++) {
+			Polygon intersection;
+			Martinez mr (*operands[i], *operands[j]);
+			mr.compute (Martinez::INTERSECTION, intersection);
+			pairArea[i * (operands.size () - nsubject) + j - nsubject] = area (intersection);
+		}
+	timer.stop ();
+	cout << "Martínez-Rueda's time (" << pairArea.size () << " pairwise intersections): " << timer.timeSecs () << endl;
+
+	ofstream f (resultName);
+	if (!f) {
+		cerr << "can't open " << resultName << '\n';
+	} else {
+		Polygon all;
+		for (unsigned i = 0; i < faces.size (); i++)
+			for (unsigned j = 0; j < faces[i].region.ncontours (); j++)
+				all.pushbackContour () = faces[i].region.contour (j);
+		f << all;
+	}
+	int status = 0;
+	// Every face must be bounded by its region, and the faces covered by an operand of each layer must add up to their
+	// intersection
+	vector<double> faceSum (pairArea.size (), 0);
+	for (unsigned i = 0; i < faces.size (); i++) {
+		if (differ (faces[i].area, area (faces[i].region))) {
+			cerr << "The face " << i << " has area " << faces[i].area << ", and its region " << area (faces[i].region) << endl;
+			status = 4;
+		}
+		const vector<unsigned>& ops = faces[i].operands;
+		unsigned first = lower_bound (ops.begin (), ops.end (), nsubject) - ops.begin ();
+		for (unsigned a = 0; a < first; a++)
+			for (unsigned b = first; b < ops.size (); b++)
+				faceSum[ops[a] * (operands.size () - nsubject) + ops[b] - nsubject] += faces[i].area;
+	}
+	vector<double> overlapArea (pairArea.size (), 0);
+	for (unsigned i = 0; i < overlaps.size (); i++)
+		overlapArea[overlaps[i].subject * (operands.size () - nsubject) + overlaps[i].clipping] = overlaps[i].area;
+	for (unsigned k = 0; k < pairArea.size (); k++) {
+		if (differ (faceSum[k], pairArea[k]) || differ (overlapArea[k], pairArea[k])) {
+			cerr << "The operands " << k / (operands.size () - nsubject) << " and " << nsubject + k % (operands.size () - nsubject)
+			     << " overlap in " << pairArea[k] << " by Martinez's intersection, " << faceSum[k] << " by the faces and "
+			     << overlapArea[k] << " by the overlap areas" << endl;
+			status = 4;
+		}
+	}
+	return status;
+}
+
+// Compute the expression with one Martínez-Rueda's operation per operator, on the results of the previous ones
+static void chain (const Expression& expr, const vector<Polygon*>& operands, Polygon& result)
+{
+	static const Martinez::BoolOpType martinezOp[] = { Martinez::INTERSECTION, Martinez::UNION, Martinez::INTERSECTION, Martinez::DIFFERENCE, Martinez::XOR };
+	deque<Polygon> partial; // results of the operations computed
+	vector<Polygon*> stack;
+	for (unsigned i = 0; i < expr.nsteps (); i++) {
+		if (expr.op (i) == Expression::OPERAND) {
+			stack.push_back (operands[expr.operand (i)]);
+			continue;
+		}
+		partial.push_back (Polygon ());
+		Martinez mr (*stack[stack.size () - 2], *stack.back ());
+		mr.compute (martinezOp[expr.op (i)], partial.back ());
+		stack.pop_back ();
+		stack.back () = &partial.back ();
+	}
+	result = *stack.back ();
+}
+
+int main (int argc, char* argv[])
+{
+	if (argc < 4) {
+		cerr << "Syntax: " << argv[0] << " expression result_pol operand_pol [operand_pol ...]\n";
+		cerr << "        " << argv[0] << " -o nsubject faces_pol operand_pol [operand_pol ...]\n";
+		cerr << "The expression is made of the operands A, B, ... (the polygons in the order given), the operators | (union), & (intersection), - (difference) and ^ (exclusive or), and parentheses\n";
+		cerr << "With -o, the overlay of the operands is computed instead: faces_pol gets the contours of its faces, and the areas where the first nsubject operands overlap the rest are compared with their intersections\n";
+		return 1;
+	}
+	if (string (argv[1]) == "-o") {
+		int nsubject = argc > 2 ? atoi (argv[2]) : 0;
+		if (argc < 6 || nsubject < 1 || nsubject > argc - 5) {
+			cerr << "Syntax: " << argv[0] << " -o nsubject faces_pol operand_pol [operand_pol ...]\n";
+			cerr << "Both layers need an operand at least\n";
+			return 2;
+		}
+		deque<Polygon> polygons;
+		vector<Polygon*> operands;
+		for (int i = 4; i < argc; i++) {
+			polygons.push_back (Polygon (argv[i]));
+			operands.push_back (&polygons.back ());
+		}
+		return overlay (nsubject, argv[3], operands);
+	}
+	Expression expr;
+	if (!expr.parse (argv[1])) {
+		cerr << "Wrong expression: " << argv[1] << '\n';
+		return 2;
+	}
+	deque<Polygon> polygons;
+	vector<Polygon*> operands;
+	for (int i = 3; i < argc; i++) {
+		polygons.push_back (Polygon (argv[i]));
+		operands.push_back (&polygons.back ());
+	}
+	Timer timer;
+
+	// The expression by one sweep over all the operands
+	Polygon result;
+	timer.start ();
+	bool ok = Martinez::compute (expr, operands, result);
+	timer.stop ();
+	if (!ok) {
+		cerr << "The expression refers to " << expr.noperands () << " operands, " << operands.size () << " polygons are given (at most "
+		     << Expression::MAX_OPERANDS << ")\n";
+		return 2;
+	}
+	cout << "Martínez-Rueda's time (one sweep): " << timer.timeSecs () << endl;
+
+	// The expression by chained boolean operations
+	Polygon chainedResult;
+	timer.start ();
+	chain (expr, operands, chainedResult);
+	timer.stop ();
+	cout << "Martínez-Rueda's time (" << (expr.nsteps () - 1) / 2 << " chained operations): " << timer.timeSecs () << endl;
+	cout << "Contours: " << result.ncontours () << " (one sweep), " << chainedResult.ncontours () << " (chained)" << endl;
+
+	ofstream f (argv[2]);
+	if (!f)
+		cerr << "can't open " << argv[2] << '\n';
+	else
+		f << result;
+	// The intersection points of the chained operations are rounded again by every operation, so the areas are compared
+	double area = contoursArea (result), chainedArea = contoursArea (chainedResult);
+	if (fabs (area - chainedArea) > 1e-9 * std::max (area, chainedArea)) {
+		cerr << "The result of the sweep differs from the chained one: their areas are " << area << " and " << chainedArea << endl;
+		return 4;
+	}
+	return 0;
+}
@@ -0,0 +1,217 @@
+#include "noder.h"
+#include "threadpool.h"
+#include "utilities.h"
+#include <algorithm>
+#include <cmath>
+
+class Noder::RowJob : public Job {
+public:
+	RowJob (Noder& n) : noder (n) {}
+	void run (unsigned j) { noder.intersectRow (j); }
+private:
+	Noder& noder;
+};
+
+class Noder::ContourJob : public Job {
+public:
+	ContourJob (Noder& n, const vector<Split>& sp, const vector<unsigned>& s, vector<Contour*>& c, vector<Contour*>& r, vector<unsigned>& f) :
+		noder (n), split (sp), start (s), contour (c), result (r), firstEdge (f) {}
+	void run (unsigned c) { noder.nodeContour (*contour[c], firstEdge[c], split, start, *result[c]); }
+private:
+	Noder& noder;
+	const vector<Split>& split;
+	const vector<unsigned>& start;
+	vector<Contour*>& contour;
+	vector<Contour*>& result;
+	vector<unsigned>& firstEdge;
+};
+
+// Is the point p placed before the point q in the sweep?
+static bool before (const Point& p, const Point& q)
+{
+	return p.x < q.x || (p.x == q.x && p.y < q.y);
+}
+
+namespace {
+/** @brief Orders the split points of an edge from its first vertex, by their coordinate along the main axis of the edge.
+ *  Unlike rounded distances, it keeps apart split points very close to each other, and the rounded ones that are slightly
+ *  off the edge */
+struct AlongEdge {
+	bool vertical, forward;
+	AlongEdge (const Point& origin, const Point& end) :
+		vertical (fabs (end.y - origin.y) > fabs (end.x - origin.x)), forward (vertical ? origin.y < end.y : origin.x < end.x) {}
+	bool operator() (const Point& a, const Point& b) const
+	{
+		double u = vertical ? a.y : a.x, v = vertical ? b.y : b.x;
+		if (u != v)
+			return forward ? u < v : v < u;
+		return vertical ? a.x < b.x : a.y < b.y;
+	}
+};
+}
+
+unsigned Noder::column (double x) const
+{
+	return static_cast<unsigned> (std::min<double> (nx - 1, std::max (0.0, (x - min.x) / cw)));
+}
+
+unsigned Noder::row (double y) const
+{
+	return static_cast<unsigned> (std::min<double> (ny - 1, std::max (0.0, (y - min.y) / ch)));
+}
+
+void Noder::compute (Polygon& nodedSubject, Polygon& nodedClipping, ThreadPool& pool)
+{
+	Polygon* polygon[2] = { &subject, &clipping };
+	Polygon* noded[2] = { &nodedSubject, &nodedClipping };
+	vector<Contour*> contour, result;
+	vector<unsigned> firstEdge;
+	edges.clear ();
+	for (int pl = 0; pl < 2; pl++) {
+		noded[pl]->clear ();
+		for (unsigned c = 0; c < polygon[pl]->ncontours (); c++) {
+			Contour& cont = polygon[pl]->contour (c);
+			contour.push_back (&cont);
+			noded[pl]->pushbackContour ();
+			firstEdge.push_back (edges.size ());
+			for (unsigned k = 0; k < cont.nedges (); k++) {
+				Segment s = cont.segment (k);
+				Edge e;
+				e.l = before (s.begin (), s.end ()) ? s.begin () : s.end ();
+				e.r = before (s.begin (), s.end ()) ? s.end () : s.begin ();
+				e.pl = pl;
+				edges.push_back (e);
+			}
+		}
+	}
+	for (int pl = 0; pl < 2; pl++)
+		for (unsigned c = 0; c < noded[pl]->ncontours (); c++)
+			result.push_back (&noded[pl]->contour (c));
+
+	route ();
+	splits.assign (ny, vector<Split> ());
+	RowJob rows (*this);
+	pool.run (rows, ny);
+
+	// Sort the split points by edge (counting sort)
+	vector<unsigned> start (edges.size () + 1, 0);
+	for (unsigned j = 0; j < ny; j++)
+		for (unsigned k = 0; k < splits[j].size (); k++)
+			start[splits[j][k].edge + 1]++;
+	for (unsigned e = 1; e < start.size (); e++)
+		start[e] += start[e-1];
+	vector<Split> split (start.back ());
+	vector<unsigned> next (start.begin (), start.end () - 1);
+	for (unsigned j = 0; j < ny; j++) {
+		for (unsigned k = 0; k < splits[j].size (); k++)
+			split[next[splits[j][k].edge]++] = splits[j][k];
+		vector<Split> ().swap (splits[j]);
+	}
+	nsplits = split.size ();
+
+	ContourJob contours (*this, split, start, contour, result, firstEdge);
+	pool.run (contours, contour.size ());
+}
+
+void Noder::route ()
+{
+	Point max;
+	if (!edges.empty ()) {
+		min = max = edges[0].l;
+		for (unsigned e = 0; e < edges.size (); e++) {
+			const Edge& ed = edges[e];
+			min.x = std::min (min.x, ed.l.x);
+			max.x = std::max (max.x, ed.r.x);
+			min.y = std::min (min.y, std::min (ed.l.y, ed.r.y));
+			max.y = std::max (max.y, std::max (ed.l.y, ed.r.y));
+		}
+	}
+	// about two edges per cell, with square cells
+	double w = std::max (max.x - min.x, 1e-300), h = std::max (max.y - min.y, 1e-300);
+	double cells = std::max (1.0, std::min (edges.size () / 2.0, 1048576.0));
+	nx = static_cast<unsigned> (std::max (1.0, std::min (cells, floor (sqrt (cells * w / h)))));
+	ny = static_cast<unsigned> (std::max (1.0, std::min (cells, floor (cells / nx))));
+	cw = w / nx;
+	ch = h / ny;
+	first.assign (nx * ny + 1, 0);
+	for (unsigned e = 0; e < edges.size (); e++) {
+		Edge& ed = edges[e];
+		ed.x0 = column (ed.l.x);
+		ed.x1 = column (ed.r.x);
+		ed.y0 = row (std::min (ed.l.y, ed.r.y));
+		ed.y1 = row (std::max (ed.l.y, ed.r.y));
+		for (unsigned y = ed.y0; y <= ed.y1; y++)
+			for (unsigned x = ed.x0; x <= ed.x1; x++)
+				first[y * nx + x]++;
+	}
+	// first[c] is the end of the cell c. The edges are stored from the end of every cell to its beginning
+	for (unsigned c = 1; c < first.size (); c++)
+		first[c] += first[c-1];
+	cell.resize (first.back ());
+	for (unsigned e = 0; e < edges.size (); e++) {
+		const Edge& ed = edges[e];
+		for (unsigned y = ed.y0; y <= ed.y1; y++)
+			for (unsigned x = ed.x0; x <= ed.x1; x++)
+				cell[--first[y * nx + x]] = e;
+	}
+}
+
+void Noder::intersectRow (unsigned j)
+{
+	vector<Split>& out = splits[j];
+	for (unsigned i = 0; i < nx; i++) {
+		unsigned c = j * nx + i;
+		for (unsigned a = first[c]; a < first[c+1]; a++) {
+			const Edge& ea = edges[cell[a]];
+			if (ea.l == ea.r)
+				continue;
+			for (unsigned b = a + 1; b < first[c+1]; b++) {
+				const Edge& eb = edges[cell[b]];
+				// the pair is tested only in the first cell shared by both edges
+				if (std::max (ea.x0, eb.x0) != i || std::max (ea.y0, eb.y0) != j || eb.l == eb.r)
+					continue;
+				if (ea.r.x < eb.l.x || eb.r.x < ea.l.x || std::max (ea.l.y, ea.r.y) < std::min (eb.l.y, eb.r.y) ||
+				    std::max (eb.l.y, eb.r.y) < std::min (ea.l.y, ea.r.y))
+					continue;
+				Point ip[2];
+				int n = findIntersection (ea.l, ea.r, ea.r.x - ea.l.x, ea.r.y - ea.l.y, eb.l, eb.r, eb.r.x - eb.l.x, eb.r.y - eb.l.y, ip[0], ip[1]);
+				if (n == 2 && ea.pl == eb.pl) // the sweep does not divide overlapping edges of the same polygon either
+					continue;
+				if (n == 2) { // the overlap is bounded by endpoints of the edges. They are taken as they are, not rounded
+					ip[0] = before (ea.l, eb.l) ? eb.l : ea.l;
+					ip[1] = before (ea.r, eb.r) ? ea.r : eb.r;
+				}
+				for (int k = 0; k < n; k++) {
+					if (ip[k] != ea.l && ip[k] != ea.r) {
+						Split s = { cell[a], ip[k] };
+						out.push_back (s);
+					}
+					if (ip[k] != eb.l && ip[k] != eb.r) {
+						Split s = { cell[b], ip[k] };
+						out.push_back (s);
+					}
+				}
+			}
+		}
+	}
+}
+
+void Noder::nodeContour (Contour& c, unsigned e, const vector<Split>& split, const vector<unsigned>& s, Contour& result) const
+{
+	vector<Point> points;
+	for (unsigned k = 0; k < c.nvertices (); k++) {
+		const Point& v = c.vertex (k);
+		const Point& w = c.vertex ((k + 1) % c.nvertices ());
+		if (result.nvertices () == 0 || result.vertex (result.nvertices () - 1) != v)
+			result.add (v);
+		points.clear ();
+		for (unsigned m = s[e+k]; m < s[e+k+1]; m++)
+			points.push_back (split[m].p);
+		sort (points.begin (), points.end (), AlongEdge (v, w));
+		for (unsigned m = 0; m < points.size (); m++)
+			if (points[m] != result.vertex (result.nvertices () - 1) && points[m] != w)
+				result.add (points[m]);
+	}
+	if (result.nvertices () > 1 && result.vertex (0) == result.vertex (result.nvertices () - 1))
+		result.erase (result.end () - 1);
+}
@@ -0,0 +1,70 @@
+// Split the edges of two polygons at their intersections before the sweep, in parallel
+
+#ifndef NODER_H
+#define NODER_H
+
+#include "polygon.h"
+#include "point.h"
+#include <vector>
+
+using namespace std;
+
+class ThreadPool;
+
+class Noder {
+public:
+	/** Class constructor */
+	Noder (Polygon& sp, Polygon& cp) : subject (sp), clipping (cp), edges (), nx (1), ny (1), first (), cell (), splits (), nsplits (0) {}
+	/** Compute the copies of the polygons whose edges are split at all their intersection points (the points where the edges of
+	 *  a polygon cross, and the points where the edges of both polygons cross or overlap). The intersections are found by
+	 *  the threads of pool, with a uniform grid as broad phase. The ends of an overlap are endpoints of the edges, so they are
+	 *  not rounded. Martinez's sweep on the noded polygons still finds their overlapping edges, but it hardly has to divide
+	 *  line segments: only a few intersections created by the rounding of the crossing points remain */
+	void compute (Polygon& nodedSubject, Polygon& nodedClipping, ThreadPool& pool);
+	/** Number of points inserted into the edges in the last computation (for statistics) */
+	unsigned nSplits () const { return nsplits; }
+
+private:
+	/** @brief Edge of a contour, with its endpoints in the order of the sweep, and the range of cells of the grid overlapped
+	 *  by its bounding box. The edges of the clipping polygon follow those of the subject */
+	struct Edge {
+		Point l, r;
+		int pl;
+		unsigned x0, x1, y0, y1;
+	};
+	/** @brief Point where an edge must be split */
+	struct Split {
+		unsigned edge;
+		Point p;
+	};
+	class RowJob;
+	class ContourJob;
+
+	Polygon& subject;
+	Polygon& clipping;
+	vector<Edge> edges;
+	Point min;
+	double cw, ch; // size of a cell
+	unsigned nx, ny;
+	/** @brief The edges of the cell c are cell[first[c]..first[c+1]) */
+	vector<unsigned> first;
+	vector<unsigned> cell;
+	/** @brief Split points found in every row of the grid, and then sorted by edge */
+	vector<vector<Split> > splits;
+	unsigned nsplits;
+
+	unsigned column (double x) const;
+	unsigned row (double y) const;
+	/** Build the grid and store the edges in the cells overlapped by their bounding boxes */
+	void route ();
+	/** Find the intersections of the pairs of edges of the cells of row j. A pair is tested in the first cell it shares */
+	void intersectRow (unsigned j);
+	/** Copy the contour c of p, whose first edge has index e, inserting its split points. split[s[k]..s[k+1]) are the split
+	 *  points of the edge k */
+	void nodeContour (Contour& c, unsigned e, const vector<Split>& split, const vector<unsigned>& s, Contour& result) const;
+
+	Noder (const Noder&);
+	Noder& operator= (const Noder&);
+};
+
+#endif
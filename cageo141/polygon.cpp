@@ -36,6 +36,44 @@ bool Contour::counterclockwise ()
 	return _CC = area >= 0.0;
 }
 
+bool Contour::convex ()
+{
+	if (_precomputedConvex)
+		return _convex;
+	_precomputedConvex = true;
+	unsigned n = nvertices ();
+	int turn = 0;   // side to which the contour turns: 1 left, -1 right
+	int xdir = 0;   // sign of the x-component of the last edge that is not vertical
+	int firstxdir = 0;
+	int xflips = 0; // changes of the sign of the x-component of the edges
+	for (unsigned i = 0; i < n; i++) {
+		const Point& a = vertex (i);
+		const Point& b = vertex ((i+1) % n);
+		const Point& c = vertex ((i+2) % n);
+		double cross = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+		if (cross == 0 && (b.x - a.x) * (c.x - b.x) + (b.y - a.y) * (c.y - b.y) < 0)
+			return _convex = false; // the contour goes back along a line
+		if (cross != 0) {
+			if (turn == 0)
+				turn = (cross > 0) ? 1 : -1;
+			else if ((cross > 0) != (turn > 0))
+				return _convex = false;
+		}
+		if (b.x != a.x) {
+			int d = (b.x > a.x) ? 1 : -1;
+			if (xdir == 0)
+				firstxdir = d;
+			else if (d != xdir)
+				xflips++;
+			xdir = d;
+		}
+	}
+	if (xdir != firstxdir)
+		xflips++;
+	// a contour that turns twice around changes more times its direction along the x-axis
+	return _convex = turn != 0 && xflips <= 2;
+}
+
 void Contour::move (double x, double y)
 {
 	for (unsigned int i = 0; i < points.size (); i++) {
@@ -111,23 +149,29 @@ ostream& operator<< (ostream& o, Polygon& p)
 	return o;
 }
 
+istream& operator>> (istream& is, Contour& contour)
+{
+	int npoints, level;
+	double px, py;
+	is >> npoints >> level;
+	for (int j = 0; j < npoints; j++) {
+		is >> px >> py;
+		if (j > 0 && px == contour.vertex (contour.nvertices ()-1).x && py == contour.vertex (contour.nvertices ()-1).y)
+			continue;
+		if (j == npoints-1 && px == contour.vertex (0).x && py == contour.vertex (0).y)
+			continue;
+		contour.add (Point (px, py));
+	}
+	return is;
+}
+
 istream& operator>> (istream& is, Polygon& p)
 {
 	int ncontours;
-	double px, py;
 	is >> ncontours;
 	for (int i = 0; i < ncontours; i++) {
-		int npoints, level;
-		is >> npoints >> level;
 		Contour& contour = p.pushbackContour ();
-		for (int j = 0; j < npoints; j++) {
-			is >> px >> py;
-			if (j > 0 && px == contour.vertex (j-1).x && py == contour.vertex (j-1).y)
-				continue;
-			if (j == npoints-1 && px == contour.vertex (0).x && py == contour.vertex (0).y)
-				continue;
-			contour.add (Point (px, py));
-		}
+		is >> contour;
 		if (contour.nvertices () < 3) {
 			p.deletebackContour ();
 			continue;
@@ -162,7 +206,7 @@ ostream& operator<< (ostream& o, SE& e)
 }
 
 struct SEComp : public binary_function<SE*, SE*, bool> {
-	bool operator() (SE* e1, SE* e2) {
+	bool operator() (SE* e1, SE* e2) const {
 		if (e1->p.x < e2->p.x) // Different x coordinate
 			return true;
 		if (e2->p.x < e1->p.x) // Different x coordinate
@@ -177,7 +221,7 @@ struct SEComp : public binary_function<SE*, SE*, bool> {
 };
 
 struct SegmentsComp : public binary_function<SE*, SE*, bool> {
-	bool operator() (SE* e1, SE* e2) {
+	bool operator() (SE* e1, SE* e2) const {
 		if (e1 == e2)
 			return false;
 		if (signedArea (e1->p, e1->other->p, e2->p) != 0 || signedArea (e1->p, e1->other->p, e2->other->p) != 0) {
@@ -11,7 +11,7 @@ class Contour {
 public:
 	typedef vector<Point>::iterator iterator;
 	
-	Contour () : points (), holes (), _external (true), _precomputedCC (false) {}
+	Contour () : points (), holes (), _external (true), _precomputedCC (false), _precomputedConvex (false), _convex (false) {}
 
 	/** Get the p-th vertex of the external contour */
 	Point& vertex (unsigned p) { return points[p]; }
@@ -28,11 +28,15 @@ public:
 	void changeOrientation () { reverse (points.begin (), points.end ()); _CC = !_CC; }
 	void setClockwise () { if (counterclockwise ()) changeOrientation (); }
 	void setCounterClockwise () { if (clockwise ()) changeOrientation (); }
+	/** Return if the contour is convex: it turns always to the same side, and only once around. Collinear vertices are allowed */
+	bool convex ();
 
 	void move (double x, double y);
-	void add (const Point& s) { points.push_back (s); }
-	void erase (iterator i) { points.erase (i); }
-	void clear () { points.clear (); holes.clear (); }
+	void add (const Point& s) { points.push_back (s); _precomputedConvex = false; }
+	/** Set the number of vertices, keeping the first ones */
+	void resize (unsigned n) { points.resize (n); _precomputedConvex = false; }
+	void erase (iterator i) { points.erase (i); _precomputedConvex = false; }
+	void clear () { points.clear (); holes.clear (); _precomputedConvex = false; }
 	iterator begin () { return points.begin (); }
 	iterator end () { return points.end (); }
 	void addHole (unsigned ind) { holes.push_back (ind); }
@@ -49,9 +53,13 @@ public:
 	bool _external; // is the contour an external contour? (i.e., is it not a hole?)
 	bool _precomputedCC;
 	bool _CC;
+	bool _precomputedConvex;
+	bool _convex;
 };
 
 ostream& operator<< (ostream& o, Contour& c);
+/** Read a contour in the format of the polygon files, appending its vertices to c. Repeated consecutive vertices are skipped */
+istream& operator>> (istream& i, Contour& c);
 
 class Polygon {
 public:
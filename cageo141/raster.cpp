@@ -0,0 +1,119 @@
+#include "raster.h"
+#include <algorithm>
+#include <cmath>
+
+Raster::Raster (float* buffer, unsigned width, unsigned height, const Point& min, const Point& max, Mode m) :
+	buf (buffer), w (width), h (height), origin (min), sx (width / (max.x - min.x)), sy (height / (max.y - min.y)), md (m)
+{
+}
+
+void Raster::clear ()
+{
+	std::fill (buf, buf + w * h, 0.0f);
+}
+
+void Raster::addEdge (const Point& a, const Point& b)
+{
+	double x0 = (a.x - origin.x) * sx, y0 = (a.y - origin.y) * sy;
+	double x1 = (b.x - origin.x) * sx, y1 = (b.y - origin.y) * sy;
+	if (y0 == y1) // horizontal edges do not change the coverage along a row
+		return;
+	if (std::max (y0, y1) <= 0 || std::min (y0, y1) >= h)
+		return;
+	// Clip the edge to the rows of the raster, and split it by the lines x = 0 and x = w. The parts of the edge at the left
+	// (or at the right) of the raster are moved to its border
+	double dx = x1 - x0, dy = y1 - y0;
+	double tb = -y0 / dy, tt = (h - y0) / dy;
+	double t[4];
+	unsigned n = 0;
+	t[n++] = std::max (0.0, std::min (tb, tt));
+	double tmax = std::min (1.0, std::max (tb, tt));
+	if (dx != 0) {
+		double tl = -x0 / dx, tr = (w - x0) / dx;
+		if (tl > t[0] && tl < tmax)
+			t[n++] = tl;
+		if (tr > t[0] && tr < tmax)
+			t[n++] = tr;
+		if (n == 3 && t[2] < t[1])
+			std::swap (t[1], t[2]);
+	}
+	t[n++] = tmax;
+	for (unsigned i = 0; i + 1 < n; i++)
+		accumulate (clamp (x0 + t[i] * dx, w), clamp (y0 + t[i] * dy, h), clamp (x0 + t[i+1] * dx, w), clamp (y0 + t[i+1] * dy, h));
+}
+
+void Raster::accumulate (double x0, double y0, double x1, double y1)
+{
+	if (y0 == y1)
+		return;
+	double dir = 1;
+	if (y0 > y1) {
+		std::swap (x0, x1);
+		std::swap (y0, y1);
+		dir = -1;
+	}
+	double dxdy = (x1 - x0) / (y1 - y0);
+	if (md == BINARY) {
+		// Every row whose center is crossed by the edge changes the winding number at the right of the crossing
+		unsigned ystart = static_cast<unsigned> (std::max (0.0, ceil (y0 - 0.5)));
+		unsigned yend = static_cast<unsigned> (std::max (0.0, std::min<double> (h, ceil (y1 - 0.5))));
+		for (unsigned y = ystart; y < yend; y++) {
+			double x = x0 + (y + 0.5 - y0) * dxdy;
+			add (static_cast<int> (ceil (x - 0.5)), y, dir);
+		}
+		return;
+	}
+	// Accumulate the signed area covered at the right of the edge in every row. The value of a pixel is the sum of
+	// the accumulated values of the pixels at its left (including itself)
+	double x = x0;
+	unsigned ystart = static_cast<unsigned> (floor (y0));
+	unsigned yend = static_cast<unsigned> (std::min<double> (h, ceil (y1)));
+	for (unsigned y = ystart; y < yend; y++) {
+		double dy = std::min (y + 1.0, y1) - std::max (static_cast<double> (y), y0);
+		double xnext = x + dxdy * dy;
+		double d = dy * dir;
+		double xa = std::min (x, xnext), xb = std::max (x, xnext);
+		double xafloor = floor (xa), xbceil = ceil (xb);
+		int xai = static_cast<int> (xafloor), xbi = static_cast<int> (xbceil);
+		if (xbi <= xai + 1) { // the edge is inside one column
+			double xmf = 0.5 * (x + xnext) - xafloor;
+			add (xai, y, d - d * xmf);
+			add (xai + 1, y, d * xmf);
+		} else {
+			double s = 1 / (xb - xa);
+			double xaf = xa - xafloor;
+			double a0 = 0.5 * s * (1 - xaf) * (1 - xaf);
+			double xbf = xb - xbceil + 1;
+			double am = 0.5 * s * xbf * xbf;
+			add (xai, y, d * a0);
+			if (xbi == xai + 2) {
+				add (xai + 1, y, d * (1 - a0 - am));
+			} else {
+				double a1 = s * (1.5 - xaf);
+				add (xai + 1, y, d * (a1 - a0));
+				for (int xi = xai + 2; xi < xbi - 1; xi++)
+					add (xi, y, d * s);
+				double a2 = a1 + (xbi - xai - 3) * s;
+				add (xbi - 1, y, d * (1 - a2 - am));
+			}
+			add (xbi, y, d * am);
+		}
+		x = xnext;
+	}
+}
+
+void Raster::resolve ()
+{
+	for (unsigned y = 0; y < h; y++) {
+		float* row = buf + y * w;
+		double acc = 0;
+		for (unsigned x = 0; x < w; x++) {
+			acc += row[x];
+			double v = fabs (acc);
+			if (md == BINARY)
+				row[x] = (v > 0.5) ? 1.0f : 0.0f;
+			else
+				row[x] = (v > 1) ? 1.0f : static_cast<float> (v);
+		}
+	}
+}
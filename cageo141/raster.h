@@ -0,0 +1,43 @@
+// Raster of coverages, written directly from the edges of a boolean operation
+
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "point.h"
+
+class Raster {
+public:
+	enum Mode { BINARY, ANTIALIASED };
+	/** Class constructor. The raster covers the window [min.x, max.x] x [min.y, max.y] with w x h pixels, stored by rows in
+	 *  the caller's buffer (the row 0 is the bottom one). In BINARY mode a pixel is 1 if its center is covered and 0 otherwise,
+	 *  in ANTIALIASED mode it is the fraction of the pixel that is covered */
+	Raster (float* buffer, unsigned w, unsigned h, const Point& min, const Point& max, Mode m = ANTIALIASED);
+	/** Set all the pixels to 0 */
+	void clear ();
+	/** Accumulate the oriented edge (a, b). The covered region is to the left of the edge */
+	void addEdge (const Point& a, const Point& b);
+	/** Turn the values accumulated by addEdge into coverages */
+	void resolve ();
+	unsigned width () const { return w; }
+	unsigned height () const { return h; }
+	Mode mode () const { return md; }
+	float* buffer () { return buf; }
+	float pixel (unsigned x, unsigned y) const { return buf[y*w+x]; }
+
+private:
+	float* buf;
+	unsigned w;
+	unsigned h;
+	Point origin;
+	double sx, sy; // pixels per unit
+	Mode md;
+
+	/** Accumulate the edge (a, b), in pixel coordinates, that is inside the strip 0 <= x <= w */
+	void accumulate (double x0, double y0, double x1, double y1);
+	/** Clamp v to the interval [0, max] */
+	static double clamp (double v, unsigned max) { return (v < 0) ? 0 : ((v > max) ? max : v); }
+	/** Add v to the pixel x of the row y, if it is inside the raster */
+	void add (int x, unsigned y, double v) { if (x < static_cast<int> (w)) buf[y*w+(x < 0 ? 0 : x)] += v; }
+};
+
+#endif
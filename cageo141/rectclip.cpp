@@ -0,0 +1,275 @@
+#include "rectclip.h"
+#include "martinez.h"
+#include <algorithm>
+
+bool RectangleClip::isRectangle (Polygon& p, Point& min, Point& max)
+{
+	if (p.ncontours () != 1 || p.contour (0).nvertices () != 4)
+		return false;
+	Contour& c = p.contour (0);
+	// the edges are horizontal and vertical alternately
+	bool horizontal[4];
+	for (unsigned k = 0; k < 4; k++) {
+		const Point& a = c.vertex (k);
+		const Point& b = c.vertex ((k + 1) % 4);
+		if (a.y == b.y && a.x != b.x)
+			horizontal[k] = true;
+		else if (a.x == b.x && a.y != b.y)
+			horizontal[k] = false;
+		else
+			return false;
+	}
+	if (horizontal[0] == horizontal[1] || horizontal[1] == horizontal[2] || horizontal[2] == horizontal[3])
+		return false;
+	c.boundingbox (min, max);
+	return true;
+}
+
+void RectangleClip::compute (Polygon& p, const Point& min, const Point& max, Polygon& result)
+{
+	// Only the edges whose bounding boxes overlap the rectangle are walked; all of them cross its center line or not
+	vector<EdgeRef> edges;
+	vector<double> crossings;
+	const double yc = (min.y + max.y) / 2;
+	for (unsigned c = 0; c < p.ncontours (); c++) {
+		Contour& contour = p.contour (c);
+		for (unsigned k = 0; k < contour.nedges (); k++) {
+			Segment s = contour.segment (k);
+			const Point& a = s.begin ();
+			const Point& b = s.end ();
+			if ((a.y > yc) != (b.y > yc))
+				crossings.push_back (a.x + (yc - a.y) * (b.x - a.x) / (b.y - a.y));
+			if (std::max (a.x, b.x) >= min.x && std::min (a.x, b.x) <= max.x && std::max (a.y, b.y) >= min.y && std::min (a.y, b.y) <= max.y)
+				edges.push_back (EdgeRef (c, k));
+		}
+	}
+	sort (crossings.begin (), crossings.end ());
+	if (clip (p, edges, crossings, min, max, result))
+		return;
+	result.clear ();
+	Polygon rectangle;
+	Contour& r = rectangle.pushbackContour ();
+	r.add (min);
+	r.add (Point (max.x, min.y));
+	r.add (max);
+	r.add (Point (min.x, max.y));
+	Martinez mr (p, rectangle);
+	mr.compute (Martinez::INTERSECTION, result);
+}
+
+namespace {
+
+/** @brief Point where the boundary of the polygon crosses the boundary of the rectangle */
+struct Crossing {
+	int side;     // 0 bottom, 1 right, 2 top, 3 left
+	double key;   // position along the side, increasing counterclockwise
+	unsigned piece;
+	bool entry;   // does the piece start at this crossing?
+	bool operator< (const Crossing& c) const { return side < c.side || (side == c.side && key < c.key); }
+};
+
+/** @brief Part of the boundary of the polygon inside the rectangle. It starts and ends at crossings */
+struct Piece {
+	vector<Point> points;
+	unsigned first, last; // crossings at the ends of the piece
+	bool used;
+};
+
+}
+
+bool RectangleClip::clip (Polygon& subject, const vector<EdgeRef>& e, const vector<double>& cx, const Point& min, const Point& max, Polygon& result)
+{
+	const double x0 = min.x, x1 = max.x, y0 = min.y, y1 = max.y;
+	const double width = x1 - x0;
+	const Point corner[4] = { Point (x0, y0), Point (x1, y0), Point (x1, y1), Point (x0, y1) };
+	vector<Crossing> crossing;
+	vector<Piece> piece;
+
+	// The edges given are consecutive runs of edges of the contours. Every run starts and ends outside the rectangle,
+	// unless it is a whole contour
+	for (unsigned r = 0; r < e.size (); ) {
+		unsigned c = e[r].contour;
+		unsigned s = r;
+		while (r < e.size () && e[r].contour == c)
+			r++;
+		Contour& contour = subject.contour (c);
+		unsigned n = contour.nvertices ();
+		// start the walk at the beginning of a run, or at an edge that starts outside the rectangle if the whole contour is routed
+		unsigned start = s;
+		while (start < r && e[start].edge == (e[(start > s) ? start - 1 : r - 1].edge + 1) % n)
+			start++;
+		if (start == r) {
+			start = s;
+			while (start < r) {
+				const Point& p = contour.vertex (e[start].edge);
+				if (p.x <= x0 || p.x >= x1 || p.y <= y0 || p.y >= y1)
+					break;
+				start++;
+			}
+			if (start == r) { // the contour is inside the rectangle
+				Contour& inner = result.pushbackContour ();
+				for (unsigned k = 0; k < n; k++)
+					inner.add (contour.vertex (k));
+				continue;
+			}
+		}
+		bool open = false;
+		for (unsigned m = s; m < r; m++) {
+			unsigned k = e[start + m - s - ((start + m - s < r) ? 0 : r - s)].edge;
+			const Point& a = contour.vertex (k);
+			const Point& b = contour.vertex ((k + 1) % n);
+			// vertices on the boundary of the rectangle are degenerate cases
+			if (((a.x == x0 || a.x == x1) && a.y >= y0 && a.y <= y1) || ((a.y == y0 || a.y == y1) && a.x >= x0 && a.x <= x1))
+				return false;
+			// Liang-Barsky clipping of the edge against the interior of the rectangle
+			const double p[4] = { a.y - b.y, b.x - a.x, b.y - a.y, a.x - b.x };
+			const double q[4] = { a.y - y0, x1 - a.x, y1 - a.y, a.x - x0 };
+			double t0 = 0, t1 = 1;
+			int side0 = -1, side1 = -1;
+			bool empty = false;
+			for (int l = 0; l < 4 && !empty; l++) {
+				if (p[l] == 0) {
+					if (q[l] <= 0)
+						empty = true;
+				} else {
+					double t = q[l] / p[l];
+					if (p[l] < 0) {
+						if (t > t0) { t0 = t; side0 = l; }
+					} else if (t < t1) {
+						t1 = t;
+						side1 = l;
+					}
+				}
+			}
+			if (empty || t0 >= t1) {
+				if (open)
+					return false;
+				continue;
+			}
+			if (side0 >= 0) { // the edge enters the rectangle
+				if (open)
+					return false;
+				Point x (a.x + t0 * (b.x - a.x), a.y + t0 * (b.y - a.y));
+				if (side0 % 2) x.x = corner[side0].x; else x.y = corner[side0].y;
+				Crossing cr = { side0, (side0 % 2) ? ((side0 == 1) ? x.y : -x.y) : ((side0 == 0) ? x.x : -x.x), static_cast<unsigned> (piece.size ()), true };
+				crossing.push_back (cr);
+				piece.push_back (Piece ());
+				piece.back ().first = crossing.size () - 1;
+				piece.back ().used = false;
+				piece.back ().points.push_back (x);
+				open = true;
+			} else if (!open) {
+				return false;
+			}
+			if (side1 >= 0) { // the edge leaves the rectangle
+				Point x (a.x + t1 * (b.x - a.x), a.y + t1 * (b.y - a.y));
+				if (side1 % 2) x.x = corner[side1].x; else x.y = corner[side1].y;
+				if (x != piece.back ().points.back ())
+					piece.back ().points.push_back (x);
+				Crossing cr = { side1, (side1 % 2) ? ((side1 == 1) ? x.y : -x.y) : ((side1 == 0) ? x.x : -x.x), static_cast<unsigned> (piece.size () - 1), false };
+				crossing.push_back (cr);
+				piece.back ().last = crossing.size () - 1;
+				open = false;
+			} else {
+				piece.back ().points.push_back (b);
+			}
+		}
+		if (open)
+			return false;
+	}
+	if (crossing.size () % 2)
+		return false;
+
+	// Reference point on the boundary of the rectangle: the point of the left or right side on its center line, the farthest
+	// one from the crossings of the polygon with the center line
+	double yc = (y0 + y1) / 2;
+	double dist[2] = { width, width };
+	for (int l = 0; l < 2; l++) {
+		double x = l ? x1 : x0;
+		vector<double>::const_iterator it = lower_bound (cx.begin (), cx.end (), x);
+		if (it != cx.end ())
+			dist[l] = std::min (dist[l], *it - x);
+		if (it != cx.begin ())
+			dist[l] = std::min (dist[l], x - *(it - 1));
+	}
+	int l = (dist[1] > dist[0]) ? 1 : 0;
+	if (dist[l] <= 1e-9 * width)
+		return false;
+	bool refInside = (lower_bound (cx.begin (), cx.end (), l ? x1 : x0) - cx.begin ()) % 2;
+	if (crossing.empty ()) {
+		if (refInside) {
+			Contour& square = result.pushbackContour ();
+			for (int k = 0; k < 4; k++)
+				square.add (corner[k]);
+		}
+		return true;
+	}
+
+	// Sort the crossings counterclockwise. The status (inside/outside the polygon) of the parts of the boundary of the rectangle
+	// between consecutive crossings alternates
+	sort (crossing.begin (), crossing.end ());
+	for (unsigned k = 0; k < crossing.size (); k++) {
+		if (crossing[k].entry)
+			piece[crossing[k].piece].first = k;
+		else
+			piece[crossing[k].piece].last = k;
+	}
+	Crossing ref = { l ? 1 : 3, l ? yc : -yc, 0, false };
+	unsigned nc = crossing.size ();
+	unsigned r0 = (lower_bound (crossing.begin (), crossing.end (), ref) - crossing.begin () + nc - 1) % nc;
+	// The part of the boundary between crossings k and k+1 is inside the polygon iff insideAfter (k)
+	#define insideAfter(k) (refInside != (((k) + nc - r0) % 2 == 1))
+
+	// Link the pieces and the parts of the boundary of the rectangle inside the polygon
+	for (unsigned s = 0; s < piece.size (); s++) {
+		if (piece[s].used)
+			continue;
+		Contour& contour = result.pushbackContour ();
+		unsigned cur = s;
+		bool forward = true;
+		do {
+			Piece& pc = piece[cur];
+			pc.used = true;
+			if (forward)
+				for (unsigned k = 0; k < pc.points.size (); k++)
+					contour.add (pc.points[k]);
+			else
+				for (unsigned k = pc.points.size (); k > 0; k--)
+					contour.add (pc.points[k-1]);
+			unsigned k = forward ? pc.last : pc.first;
+			unsigned next;
+			vector<Point> corners;
+			if (insideAfter (k)) { // walk the boundary of the rectangle counterclockwise
+				next = (k + 1) % nc;
+				cornersBetween (crossing[k].side, crossing[k].key, crossing[next].side, crossing[next].key, corner, corners);
+			} else {               // walk it clockwise
+				next = (k + nc - 1) % nc;
+				cornersBetween (crossing[next].side, crossing[next].key, crossing[k].side, crossing[k].key, corner, corners);
+				reverse (corners.begin (), corners.end ());
+			}
+			for (unsigned m = 0; m < corners.size (); m++)
+				if (corners[m] != contour.vertex (contour.nvertices () - 1))
+					contour.add (corners[m]);
+			cur = crossing[next].piece;
+			forward = crossing[next].entry;
+		} while (!piece[cur].used);
+		if (cur != s)
+			return false;
+		// the last crossing may be repeated at the end of the contour
+		if (contour.nvertices () > 1 && contour.vertex (0) == contour.vertex (contour.nvertices () - 1))
+			contour.erase (contour.end () - 1);
+	}
+	#undef insideAfter
+	return true;
+}
+
+void RectangleClip::cornersBetween (int side0, double key0, int side1, double key1, const Point* corner, vector<Point>& corners)
+{
+	if (side0 == side1 && key1 >= key0)
+		return;
+	int s = side0;
+	do {
+		s = (s + 1) % 4;
+		corners.push_back (corner[s]);
+	} while (s != side1);
+}
@@ -0,0 +1,37 @@
+// Intersection of a polygon with an axis-aligned rectangle, in time linear in the number of edges of the polygon
+
+#ifndef RECTCLIP_H
+#define RECTCLIP_H
+
+#include "polygon.h"
+#include "point.h"
+#include <vector>
+
+using namespace std;
+
+class RectangleClip {
+public:
+	/** @brief Edge of a polygon: the edge joins the vertices edge and edge+1 of the contour */
+	struct EdgeRef {
+		unsigned contour;
+		unsigned edge;
+		EdgeRef (unsigned c, unsigned e) : contour (c), edge (e) {}
+	};
+
+	/** Is p a single axis-aligned rectangle? If it is, min and max are its bottom-left and top-right corners */
+	static bool isRectangle (Polygon& p, Point& min, Point& max);
+	/** Compute the intersection of p with the rectangle of corners min and max. Its holes, and the contours of p that cross
+	 *  each other, are handled by parity. The degenerate cases are computed with Martinez's algorithm */
+	static void compute (Polygon& p, const Point& min, const Point& max, Polygon& result);
+	/** Compute the intersection of p with the rectangle of corners min and max, from the edges of p that can reach the rectangle
+	 *  (grouped by contour, in the order of the contour) and the sorted x-coordinates of the crossings of all the edges of p with
+	 *  the horizontal line through the center of the rectangle. It returns false in degenerate cases (a vertex of p on the
+	 *  boundary of the rectangle, for example), leaving a partial result */
+	static bool clip (Polygon& p, const vector<EdgeRef>& edges, const vector<double>& crossings, const Point& min, const Point& max, Polygon& result);
+
+private:
+	/** Corners of the rectangle found walking its boundary counterclockwise from the position (side0, key0) to the position (side1, key1) */
+	static void cornersBetween (int side0, double key0, int side1, double key1, const Point* corner, vector<Point>& corners);
+};
+
+#endif
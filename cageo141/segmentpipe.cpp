@@ -0,0 +1,88 @@
+#include "segmentpipe.h"
+#include "connector.h"
+#include <sched.h>
+
+SegmentPipe::SegmentPipe (Connector& c, unsigned capacity) : connector (c), ring (0), mask (0), done (false), written (0), headSeen (0), running (false)
+{
+	unsigned size = BATCH;
+	while (size < capacity)
+		size *= 2;
+	ring = new Segment[size];
+	mask = size - 1;
+	tail.value = head.value = 0;
+	running = pthread_create (&thread, 0, threadMain, this) == 0;
+}
+
+SegmentPipe::~SegmentPipe ()
+{
+	finish ();
+	delete [] ring;
+}
+
+void SegmentPipe::push (const Segment& s)
+{
+	if (!running) { // the thread could not be created: the line segments are linked right away
+		connector.add (s);
+		return;
+	}
+	while (written - headSeen > mask) { // the ring buffer is full
+		publish ();
+		headSeen = head.value;
+		__sync_synchronize (); // the slot is written after the consumer has read it
+		if (written - headSeen > mask)
+			sched_yield ();
+	}
+	ring[written & mask] = s;
+	if (++written % BATCH == 0)
+		publish ();
+}
+
+void SegmentPipe::publish ()
+{
+	__sync_synchronize (); // the line segments are written before tail
+	tail.value = written;
+}
+
+void SegmentPipe::finish ()
+{
+	if (!running)
+		return;
+	publish ();
+	__sync_synchronize ();
+	done = true;
+	pthread_join (thread, 0);
+	running = false;
+}
+
+void SegmentPipe::consume ()
+{
+	unsigned h = head.value;
+	for (;;) {
+		// done is read before tail: once it is set, tail is final
+		bool finished = done;
+		__sync_synchronize ();
+		unsigned t = tail.value;
+		__sync_synchronize (); // the line segments are read after tail
+		if (h == t) {
+			if (finished)
+				return;
+			sched_yield ();
+			continue;
+		}
+		while (h != t) {
+			connector.add (ring[h & mask]);
+			if (++h % BATCH == 0) {
+				__sync_synchronize (); // the slots are released after they are read
+				head.value = h;
+			}
+		}
+		__sync_synchronize ();
+		head.value = h;
+	}
+}
+
+void* SegmentPipe::threadMain (void* arg)
+{
+	static_cast<SegmentPipe*> (arg)->consume ();
+	return 0;
+}
@@ -0,0 +1,57 @@
+// Line segments of a result sent from the sweep to a connector that links them in a thread of its own
+
+#ifndef SEGMENTPIPE_H
+#define SEGMENTPIPE_H
+
+#include "segment.h"
+#include <pthread.h>
+
+class Connector;
+
+class SegmentPipe {
+public:
+	/** Class constructor. It starts the thread that adds the line segments pushed to c. The ring buffer holds capacity
+	 *  line segments (rounded up to a power of 2) */
+	SegmentPipe (Connector& c, unsigned capacity = 1 << 12);
+	/** Class destructor. It calls finish */
+	~SegmentPipe ();
+	/** Send the line segment s to the connector, waiting while the ring buffer is full. Only one thread may push */
+	void push (const Segment& s);
+	/** Wait until the connector has linked all the line segments pushed, and stop its thread */
+	void finish ();
+
+private:
+	/** @brief The line segments are published to the connector in batches of this size, so that the threads seldom share
+	 *  the cache lines of the counters */
+	static const unsigned BATCH = 64;
+	/** @brief Counter written by one thread and read by the other, in a cache line of its own */
+	struct Counter {
+		volatile unsigned value;
+		char pad[64 - sizeof (unsigned)];
+	};
+
+	Connector& connector;
+	Segment* ring;
+	unsigned mask;
+	/** @brief Number of line segments published by the producer, and number of line segments linked by the consumer. The ring
+	 *  buffer holds the line segments [head, tail) */
+	Counter tail;
+	Counter head;
+	volatile bool done;
+	/** @brief Producer's copies: line segments written (published or not), and the last value of head read */
+	unsigned written;
+	unsigned headSeen;
+	pthread_t thread;
+	bool running;
+
+	/** Publish the line segments written by the producer */
+	void publish ();
+	/** Link the line segments until finish is called and the ring buffer is empty */
+	void consume ();
+	static void* threadMain (void* arg);
+
+	SegmentPipe (const SegmentPipe&);
+	SegmentPipe& operator= (const SegmentPipe&);
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include "threadpool.h"
+#include <unistd.h>
+
+ThreadPool::ThreadPool (unsigned nthreads) : nt (nthreads ? nthreads : nprocessors ()), job (0), generation (0), running (0), quit (false)
+{
+	pthread_mutex_init (&mutex, 0);
+	pthread_cond_init (&start, 0);
+	pthread_cond_init (&done, 0);
+	ranges = new Range[nt];
+	for (unsigned i = 0; i < nt; i++) {
+		pthread_mutex_init (&ranges[i].lock, 0);
+		ranges[i].begin = ranges[i].end = 0;
+	}
+	// thread 0 is the thread that calls run
+	threads = new pthread_t[nt];
+	args = new ThreadArg[nt];
+	for (unsigned i = 1; i < nt; i++) {
+		args[i].pool = this;
+		args[i].index = i;
+		pthread_create (&threads[i], 0, threadMain, &args[i]);
+	}
+}
+
+ThreadPool::~ThreadPool ()
+{
+	pthread_mutex_lock (&mutex);
+	quit = true;
+	pthread_cond_broadcast (&start);
+	pthread_mutex_unlock (&mutex);
+	for (unsigned i = 1; i < nt; i++)
+		pthread_join (threads[i], 0);
+	for (unsigned i = 0; i < nt; i++)
+		pthread_mutex_destroy (&ranges[i].lock);
+	pthread_cond_destroy (&done);
+	pthread_cond_destroy (&start);
+	pthread_mutex_destroy (&mutex);
+	delete [] ranges;
+	delete [] args;
+	delete [] threads;
+}
+
+unsigned ThreadPool::nprocessors ()
+{
+	long n = sysconf (_SC_NPROCESSORS_ONLN);
+	return (n > 0) ? n : 1;
+}
+
+void ThreadPool::run (Job& j, unsigned ntasks)
+{
+	if (ntasks == 0)
+		return;
+	pthread_mutex_lock (&mutex);
+	job = &j;
+	// Initially every thread owns a contiguous block of tasks
+	for (unsigned i = 0; i < nt; i++) {
+		pthread_mutex_lock (&ranges[i].lock);
+		ranges[i].begin = (unsigned long long) ntasks * i / nt;
+		ranges[i].end = (unsigned long long) ntasks * (i+1) / nt;
+		pthread_mutex_unlock (&ranges[i].lock);
+	}
+	running = nt - 1;
+	generation++;
+	pthread_cond_broadcast (&start);
+	pthread_mutex_unlock (&mutex);
+
+	work (0);
+
+	pthread_mutex_lock (&mutex);
+	while (running > 0)
+		pthread_cond_wait (&done, &mutex);
+	job = 0;
+	pthread_mutex_unlock (&mutex);
+}
+
+void ThreadPool::work (unsigned w)
+{
+	unsigned task;
+	for (;;) {
+		if (take (w, task))
+			job->run (task);
+		else if (!steal (w))
+			return;
+	}
+}
+
+bool ThreadPool::take (unsigned w, unsigned& task)
+{
+	Range& r = ranges[w];
+	pthread_mutex_lock (&r.lock);
+	bool found = r.begin < r.end;
+	if (found)
+		task = r.begin++;
+	pthread_mutex_unlock (&r.lock);
+	return found;
+}
+
+bool ThreadPool::steal (unsigned w)
+{
+	for (unsigned k = 1; k < nt; k++) {
+		Range& victim = ranges[(w + k) % nt];
+		pthread_mutex_lock (&victim.lock);
+		if (victim.begin < victim.end) {
+			unsigned end = victim.end;
+			unsigned begin = end - (end - victim.begin + 1) / 2;
+			victim.end = begin;
+			pthread_mutex_unlock (&victim.lock);
+			pthread_mutex_lock (&ranges[w].lock);
+			ranges[w].begin = begin;
+			ranges[w].end = end;
+			pthread_mutex_unlock (&ranges[w].lock);
+			return true;
+		}
+		pthread_mutex_unlock (&victim.lock);
+	}
+	return false;
+}
+
+void* ThreadPool::threadMain (void* arg)
+{
+	ThreadPool* pool = static_cast<ThreadArg*> (arg)->pool;
+	unsigned index = static_cast<ThreadArg*> (arg)->index;
+	unsigned seen = 0;
+	for (;;) {
+		pthread_mutex_lock (&pool->mutex);
+		while (pool->generation == seen && !pool->quit)
+			pthread_cond_wait (&pool->start, &pool->mutex);
+		if (pool->quit) {
+			pthread_mutex_unlock (&pool->mutex);
+			return 0;
+		}
+		seen = pool->generation;
+		pthread_mutex_unlock (&pool->mutex);
+
+		pool->work (index);
+
+		pthread_mutex_lock (&pool->mutex);
+		if (--pool->running == 0)
+			pthread_cond_signal (&pool->done);
+		pthread_mutex_unlock (&pool->mutex);
+	}
+}
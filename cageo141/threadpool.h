@@ -0,0 +1,64 @@
+// Thread pool. The tasks of a job are distributed among the threads by work stealing
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+
+/** @brief A job made of independent tasks, identified by their index */
+class Job {
+public:
+	virtual ~Job () {}
+	/** Run the i-th task of the job */
+	virtual void run (unsigned i) = 0;
+};
+
+class ThreadPool {
+public:
+	/** Class constructor. If nthreads is 0 one thread per processor is used */
+	ThreadPool (unsigned nthreads = 0);
+	/** Class destructor */
+	~ThreadPool ();
+	/** Run the tasks 0, 1, ..., ntasks-1 of job j. The calling thread also works. It returns when all the tasks are done */
+	void run (Job& j, unsigned ntasks);
+	/** Number of threads (including the calling thread) */
+	unsigned nthreads () const { return nt; }
+	/** Number of processors available */
+	static unsigned nprocessors ();
+
+private:
+	/** @brief Range of task indexes [begin, end) owned by a thread. The owner takes tasks from the begin, thieves take tasks from the end */
+	struct Range {
+		pthread_mutex_t lock;
+		unsigned begin, end;
+	};
+	struct ThreadArg {
+		ThreadPool* pool;
+		unsigned index;
+	};
+
+	unsigned nt;
+	pthread_t* threads;
+	ThreadArg* args;
+	Range* ranges;
+	pthread_mutex_t mutex;
+	pthread_cond_t start;
+	pthread_cond_t done;
+	Job* job;
+	unsigned generation; // number of jobs launched
+	unsigned running;    // number of threads still working in the current job
+	bool quit;
+
+	/** Execute tasks of the current job on behalf of thread w until there is no work left */
+	void work (unsigned w);
+	/** Take the next task of the range of thread w */
+	bool take (unsigned w, unsigned& task);
+	/** Move half of the remaining tasks of another thread to the range of thread w */
+	bool steal (unsigned w);
+	static void* threadMain (void* arg);
+
+	ThreadPool (const ThreadPool&);
+	ThreadPool& operator= (const ThreadPool&);
+};
+
+#endif
@@ -0,0 +1,72 @@
+#include "polygon.h"
+#include "martinez.h"
+#include "gridcut.h"
+#include "threadpool.h"
+#include "timer.h"
+#include <fstream>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+int main (int argc, char* argv[])
+{
+	if (argc < 5) {
+		cerr << "Syntax: " << argv[0] << " subject_pol tile_width tile_height result_pol [nthreads]\n";
+		return 1;
+	}
+	Polygon subj (argv[1]);
+	double width = atof (argv[2]);
+	double height = atof (argv[3]);
+	unsigned nthreads = (argc > 5) ? atoi (argv[5]) : 0;
+	if (width <= 0 || height <= 0) {
+		cerr << "The size of the tiles must be positive\n";
+		return 2;
+	}
+	Point min, max;
+	subj.boundingbox (min, max);
+	unsigned nx = std::max (1.0, ceil ((max.x - min.x) / width));
+	unsigned ny = std::max (1.0, ceil ((max.y - min.y) / height));
+	Timer timer;
+
+	// One Martínez-Rueda's intersection per tile
+	timer.start ();
+	unsigned ncontours = 0;
+	for (unsigned j = 0; j < ny; j++)
+		for (unsigned i = 0; i < nx; i++) {
+			Polygon tile;
+			Contour& square = tile.pushbackContour ();
+			square.add (Point (min.x + i * width, min.y + j * height));
+			square.add (Point (min.x + (i+1) * width, min.y + j * height));
+			square.add (Point (min.x + (i+1) * width, min.y + (j+1) * height));
+			square.add (Point (min.x + i * width, min.y + (j+1) * height));
+			Polygon result;
+			Martinez mr (subj, tile);
+			mr.compute (Martinez::INTERSECTION, result);
+			ncontours += result.ncontours ();
+		}
+	timer.stop ();
+	cout << "Martínez-Rueda's time (tile by tile): " << timer.timeSecs () << endl;
+
+	// Grid cut
+	ThreadPool pool (nthreads);
+	vector<Polygon> tiles;
+	GridCut gc (subj, min, width, height, nx, ny);
+	timer.start ();
+	gc.compute (tiles, pool);
+	timer.stop ();
+	cout << "Grid cut time (" << pool.nthreads () << " threads): " << timer.timeSecs () << endl;
+	cout << "Tiles: " << nx << " x " << ny << " = " << nx * ny << " (" << gc.nClipped () << " clipped)" << endl;
+
+	Polygon all;
+	for (unsigned t = 0; t < tiles.size (); t++)
+		for (unsigned c = 0; c < tiles[t].ncontours (); c++)
+			all.pushbackContour () = tiles[t].contour (c);
+	cout << "Contours: " << ncontours << " (tile by tile), " << all.ncontours () << " (grid cut)" << endl;
+	ofstream f (argv[4]);
+	if (!f)
+		cerr << "can't open " << argv[4] << '\n';
+	else
+		f << all;
+	return 0;
+}
@@ -32,9 +32,14 @@ static int findIntersection (double u0, double u1, double v0, double v1, double
 int findIntersection (const Segment& seg0, const Segment& seg1, Point& pi0, Point& pi1)
 {
 	const Point& p0 = seg0.begin ();
-	Point d0 (seg0.end ().x - p0.x, seg0.end ().y - p0.y);
 	const Point& p1 = seg1.begin ();
-	Point d1 (seg1.end ().x - p1.x, seg1.end ().y - p1.y);
+	return findIntersection (p0, seg0.end (), seg0.end ().x - p0.x, seg0.end ().y - p0.y, p1, seg1.end (), seg1.end ().x - p1.x, seg1.end ().y - p1.y, pi0, pi1);
+}
+
+int findIntersection (const Point& p0, const Point& q0, double dx0, double dy0, const Point& p1, const Point& q1, double dx1, double dy1, Point& pi0, Point& pi1)
+{
+	Point d0 (dx0, dy0);
+	Point d1 (dx1, dy1);
 	double sqrEpsilon = 0.0000001; // it was 0.001 before
 	Point E (p1.x - p0.x, p1.y - p0.y);
 	double kross = d0.x * d1.y - d0.y * d1.x;
@@ -55,10 +60,10 @@ int findIntersection (const Segment& seg0, const Segment& seg1, Point& pi0, Poin
 		// intersection of lines is a point an each segment
 		pi0.x = p0.x + s * d0.x;
 		pi0.y = p0.y + s * d0.y;
-		if (pi0.dist (seg0.begin ()) < 0.00000001) pi0 = seg0.begin ();
-		if (pi0.dist (seg0.end ()) < 0.00000001) pi0 = seg0.end ();
-		if (pi0.dist (seg1.begin ()) < 0.00000001) pi0 = seg1.begin ();
-		if (pi0.dist (seg1.end ()) < 0.00000001) pi0 = seg1.end ();
+		if (pi0.dist (p0) < 0.00000001) pi0 = p0;
+		if (pi0.dist (q0) < 0.00000001) pi0 = q0;
+		if (pi0.dist (p1) < 0.00000001) pi0 = p1;
+		if (pi0.dist (q1) < 0.00000001) pi0 = q1;
 		return 1;
 	}
 
@@ -82,10 +87,10 @@ int findIntersection (const Segment& seg0, const Segment& seg1, Point& pi0, Poin
 	if (imax > 0) {
 		pi0.x = p0.x + w[0] * d0.x;
 		pi0.y = p0.y + w[0] * d0.y;
-		if (pi0.dist (seg0.begin ()) < 0.00000001) pi0 = seg0.begin ();
-		if (pi0.dist (seg0.end ()) < 0.00000001) pi0 = seg0.end ();
-		if (pi0.dist (seg1.begin ()) < 0.00000001) pi0 = seg1.begin ();
-		if (pi0.dist (seg1.end ()) < 0.00000001) pi0 = seg1.end ();
+		if (pi0.dist (p0) < 0.00000001) pi0 = p0;
+		if (pi0.dist (q0) < 0.00000001) pi0 = q0;
+		if (pi0.dist (p1) < 0.00000001) pi0 = p1;
+		if (pi0.dist (q1) < 0.00000001) pi0 = q1;
 		if (imax > 1) {
 			pi1.x = p0.x + w[1] * d0.x;
 			pi1.y = p0.y + w[1] * d0.y;
@@ -6,6 +6,8 @@
 #include "polygon.h"
 
 int findIntersection (const Segment& seg0, const Segment& seg1, Point& ip0, Point& ip1);
+/** Intersection of the line segments (a0, b0) and (a1, b1), whose direction vectors (b - a) are (dx0, dy0) and (dx1, dy1) */
+int findIntersection (const Point& a0, const Point& b0, double dx0, double dy0, const Point& a1, const Point& b1, double dx1, double dy1, Point& ip0, Point& ip1);
 
 /** Signed area of the triangle (p0, p1, p2) */
 inline float signedArea (const Point& p0, const Point& p1, const Point& p2)